@@ -8,199 +8,1038 @@
 #include <ctime>
 #include <limits>
 #include <map>
+#include <unordered_map>
+#include <queue>
+#include <array>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <iterator>
 #include <algorithm>
 #include <climits>
+#include <cmath>
 #include "nlohmann/json.hpp"
 #include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <csignal>
+#endif
 using json = nlohmann::json;
 
 
 
 using namespace std;
 
-// Cross-platform clear screen function
+// Headless mode (--headless, or output not a terminal) skips screen clearing.
+bool headlessMode = false;
+
+// Clears the terminal in-process with ANSI escapes; no shell is spawned.
 void clearScreen() {
+    if (headlessMode) return;
+#ifdef _WIN32
+    static bool vtEnabled = false;
+    if (!vtEnabled) {
+        HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(out, &mode)) SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        vtEnabled = true;
+    }
+#endif
+    cout << "\033[2J\033[H" << flush;
+}
+
+// True when stdout is an interactive terminal.
+bool stdoutIsTerminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(fileno(stdout)) != 0;
+#endif
+}
+
+// Waits up to `ms` for input on stdin; false on timeout. Only a terminal is
+// polled: piped input may already sit in stdio's buffer, where poll cannot
+// see it, so there (and on Windows) this returns true at once.
+bool waitForInput(int ms) {
 #ifdef _WIN32
-    system("cls");
+    (void)ms;
+    return true;
 #else
-    system("clear");
+    if (!isatty(STDIN_FILENO)) return true;
+    pollfd p = {STDIN_FILENO, POLLIN, 0};
+    return poll(&p, 1, ms) != 0;
 #endif
 }
 
+// Files that could not be opened or written so far. The warning is printed
+// where it happens; batch runs add this to their summary and exit status.
+atomic<size_t> writeFailures{0};
+
+// Writes a file through a temp file and rename, so readers such as
+// dashboard.py never see it half-written.
+bool replaceFileAtomic(const string& path, const function<void(ostream&)>& fill) {
+    string tmp = path + ".tmp";
+    {
+        ofstream fout(tmp, ios::binary | ios::trunc);
+        if (!fout) return false;
+        fill(fout);
+        if (!fout) return false;
+    }
+    std::error_code ec;
+    filesystem::rename(tmp, path, ec);   // replaces an existing file
+    return !ec;
+}
+
+// Path of a data file inside a tracker's directory; "." keeps bare names.
+string dataPath(const string& dir, const string& file) {
+    return dir == "." ? file : dir + "/" + file;
+}
+
 // -------------------- TREE & GRAPH SUPPORT STRUCTURES --------------------
-struct HabitNode {
-    int day;
-    bool success;
-    int motivation;
-    HabitNode* left;
-    HabitNode* right;
+// Fixed-size slab of day entries, laid out column by column.
+struct DaySlab {
+    static constexpr size_t CAPACITY = 256;
+    uint32_t days[CAPACITY];
+    uint64_t successBits[CAPACITY / 64];   // bit i set => entry i was a success
+    uint8_t motivations[CAPACITY];
+};
+
+// Columnar day store: one entry per tracked day, appended in O(1).
+// Entries live in owned slabs, so growth never moves earlier days and
+// teardown is one free per slab. Move-only: copies would duplicate history.
+class DayLog {
+private:
+    vector<unique_ptr<DaySlab>> slabs;
+    size_t count;
+
+    const DaySlab& slabFor(size_t i) const { return *slabs[i / DaySlab::CAPACITY]; }
+
+public:
+    DayLog() : count(0) {}
+    DayLog(const DayLog&) = delete;
+    DayLog& operator=(const DayLog&) = delete;
+    DayLog(DayLog&& other) noexcept : slabs(std::move(other.slabs)), count(other.count) { other.count = 0; }
+    DayLog& operator=(DayLog&& other) noexcept {
+        slabs = std::move(other.slabs);
+        count = other.count;
+        other.count = 0;
+        return *this;
+    }
+
+    void append(uint32_t day, bool success, int motivation) {
+        size_t slot = count % DaySlab::CAPACITY;
+        if (slot == 0) slabs.push_back(make_unique<DaySlab>());   // value-init zeroes the bits
+        DaySlab& slab = *slabs.back();
+        slab.days[slot] = day;
+        if (success) slab.successBits[slot / 64] |= (uint64_t(1) << (slot % 64));
+        slab.motivations[slot] = static_cast<uint8_t>(max(0, min(255, motivation)));
+        ++count;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    uint32_t dayAt(size_t i) const { return slabFor(i).days[i % DaySlab::CAPACITY]; }
+    bool successAt(size_t i) const {
+        size_t slot = i % DaySlab::CAPACITY;
+        return (slabFor(i).successBits[slot / 64] >> (slot % 64)) & 1;
+    }
+    int motivationAt(size_t i) const { return slabFor(i).motivations[i % DaySlab::CAPACITY]; }
 
-    HabitNode(int d, bool s, int m)
-        : day(d), success(s), motivation(m), left(nullptr), right(nullptr) {}
+    // Visit entries in insertion order: fn(day, success, motivation).
+    template <class Fn>
+    void forEach(Fn&& fn) const {
+        size_t remaining = count;
+        for (const auto& slab : slabs) {
+            size_t n = min(remaining, DaySlab::CAPACITY);
+            for (size_t slot = 0; slot < n; ++slot)
+                fn(slab->days[slot], ((slab->successBits[slot / 64] >> (slot % 64)) & 1) != 0,
+                   static_cast<int>(slab->motivations[slot]));
+            remaining -= n;
+        }
+    }
 };
 
 // For tracking per-habit 21-day progress
+// Stored as a DayLog; the JSON export still uses the historical tree shape
+// (day 1 at the root, later successes chained left, failures chained right).
 class HabitTree {
 private:
-    HabitNode* root;
+    DayLog log;
     int currentDay;
+    // running aggregates, kept in step with log by insert()
+    int successTotal;
+    int failTotal;
+    long long motivationSum;
+    int nodeCount;
+
+    static void writeEntryFields(ostream& out, size_t day, bool success, int motivation) {
+        out << "\"day\":" << day << ",\"motivation\":" << motivation
+            << ",\"success\":" << (success ? "true" : "false");
+    }
+
+    // Stream one chain as nested objects. Each node writes its own fields and
+    // the unused link before the nested link, so closing needs only a count.
+    void writeChain(ostream& out, bool success) const {
+        const char* link = success ? "left" : "right";
+        const char* unused = success ? "right" : "left";
+        size_t open = 0;
+        for (size_t i = 1; i < log.size(); ++i) {
+            if (log.successAt(i) != success) continue;
+            out << '{';
+            writeEntryFields(out, log.dayAt(i), success, log.motivationAt(i));
+            out << ",\"" << unused << "\":null,\"" << link << "\":";
+            ++open;
+        }
+        out << "null";
+        for (; open > 0; --open) out << '}';
+    }
+
+    void append(uint32_t day, bool success, int motivation) {
+        log.append(day, success, motivation);
+        if (success) successTotal++;
+        else failTotal++;
+        motivationSum += log.motivationAt(log.size() - 1);
+        nodeCount++;
+    }
 
 public:
-    HabitTree() : root(nullptr), currentDay(0) {}
-// in HabitTree (public)
-        json nodeToJson(HabitNode* node) const {
-            if (!node) return nullptr;
-            json j;
-            j["day"] = node->day;
-            j["success"] = node->success;
-            j["motivation"] = node->motivation;
-            if (node->left)  j["left"]  = nodeToJson(node->left);
-            else j["left"] = nullptr;
-            if (node->right) j["right"] = nodeToJson(node->right);
-            else j["right"] = nullptr;
-            return j;
+    HabitTree()
+        : currentDay(0), successTotal(0), failTotal(0), motivationSum(0), nodeCount(0) {}
+
+        // Stream the tree JSON without building a DOM: O(1) working set and no
+        // recursion, however long the history is.
+        void writeJson(ostream& out) const {
+            if (log.empty()) {
+                out << "null";
+                return;
+            }
+            out << '{';
+            writeEntryFields(out, log.dayAt(0), log.successAt(0), log.motivationAt(0));
+            out << ",\"left\":";
+            writeChain(out, true);
+            out << ",\"right\":";
+            writeChain(out, false);
+            out << '}';
         }
 
         // export whole tree to file (public)
         void exportToJsonFile(const std::string& filename) const {
-            json out = nodeToJson(root);
-            std::ofstream fout(filename);
-            if (fout) fout << out.dump(4);
+            if (!replaceFileAtomic(filename, [this](ostream& out) { writeJson(out); })) {
+                ++writeFailures;
+                cerr << "Warning: cannot write " << filename << '\n';
+            }
         }
 
+    template <class Fn>
+    void forEachDay(Fn&& fn) const { log.forEach(std::forward<Fn>(fn)); }
+
     void insert(bool success, int motivation) {
         ++currentDay;
-        if (!root) {
-            root = new HabitNode(currentDay, success, motivation);
-            return;
-        }
-        HabitNode* curr = root;
-        while (true) {
-            if (success) {
-                if (!curr->left) {
-                    curr->left = new HabitNode(currentDay, success, motivation);
-                    break;
-                }
-                curr = curr->left;
-            } else {
-                if (!curr->right) {
-                    curr->right = new HabitNode(currentDay, success, motivation);
-                    break;
-                }
-                curr = curr->right;
-            }
-        }
+        append(currentDay, success, motivation);
     }
 
-    void inorder(HabitNode* node, int& successCount, int& failCount, int& totalMotivation, int& nodeCount) const {
-        if (!node) return;
-        inorder(node->left, successCount, failCount, totalMotivation, nodeCount);
-        if (node->success) successCount++;
-        else failCount++;
-        totalMotivation += node->motivation;
-        nodeCount++;
-        inorder(node->right, successCount, failCount, totalMotivation, nodeCount);
+    // Re-append a persisted entry (snapshot load / journal replay).
+    void restore(uint32_t day, bool success, int motivation) {
+        currentDay = max(currentDay, static_cast<int>(day));
+        append(day, success, motivation);
+    }
+
+    int getCurrentDay() const { return currentDay; }
+    size_t size() const { return log.size(); }
+
+    // Full scan of the day log; used to cross-check the running aggregates.
+    void recount(int& successCount, int& failCount, long long& totalMotivation, int& count) const {
+        successCount = failCount = count = 0;
+        totalMotivation = 0;
+        forEachDay([&](uint32_t, bool success, int motivation) {
+            if (success) successCount++;
+            else failCount++;
+            totalMotivation += motivation;
+            count++;
+        });
     }
 
+    // O(1): reads the aggregates maintained by insert().
+    // Build with -DHABIT_DEBUG to verify them against a full scan.
     void getStats(double& formation, double& avgMotivation, int& successCount, int& failCount) const {
-        successCount = failCount = 0;
-        int totalMotivation = 0, nodeCount = 0;
-        inorder(root, successCount, failCount, totalMotivation, nodeCount);
+#ifdef HABIT_DEBUG
+        int s = 0, f = 0, n = 0;
+        long long m = 0;
+        recount(s, f, m, n);
+        assert(s == successTotal && f == failTotal && m == motivationSum && n == nodeCount);
+#endif
+        successCount = successTotal;
+        failCount = failTotal;
         // formation as percentage of 21-day habit formation target (if desired)
         formation = (successCount / 21.0) * 100.0;
-        avgMotivation = (nodeCount > 0) ? (totalMotivation / static_cast<double>(nodeCount)) : 0.0;
+        avgMotivation = (nodeCount > 0) ? (motivationSum / static_cast<double>(nodeCount)) : 0.0;
+    }
+};
+
+// -------------------- HABIT IDS --------------------
+// Stable integer ids for habit names, shared by the tracker, the graph and
+// the exporters. Ids are dense and never reused, so a name keeps its id for
+// the life of the process. Lookup is an open-addressing table (linear
+// probing, power-of-two capacity, load factor <= 1/2). Thread-safe: lookups
+// share a reader lock, and names live in a deque so a returned name stays
+// valid while other threads intern new ones.
+using HabitId = uint32_t;
+const HabitId NO_HABIT = UINT32_MAX;
+
+class HabitIndex {
+private:
+    deque<string> names;       // by id
+    vector<uint32_t> hashes;   // by id, avoids rehashing on growth
+    vector<HabitId> slots;     // NO_HABIT marks an empty slot
+    mutable shared_mutex lock;
+
+    static uint32_t hashName(const string& s) {
+        uint32_t h = 2166136261u;   // FNV-1a
+        for (char c : s) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    size_t probe(const string& name, uint32_t h) const {
+        size_t mask = slots.size() - 1;
+        size_t i = h & mask;
+        while (slots[i] != NO_HABIT && (hashes[slots[i]] != h || names[slots[i]] != name)) i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        vector<HabitId> bigger(slots.empty() ? 16 : slots.size() * 2, NO_HABIT);
+        slots.swap(bigger);
+        size_t mask = slots.size() - 1;
+        for (HabitId id = 0; id < names.size(); ++id) {
+            size_t i = hashes[id] & mask;
+            while (slots[i] != NO_HABIT) i = (i + 1) & mask;
+            slots[i] = id;
+        }
+    }
+
+public:
+    HabitIndex() { grow(); }
+
+    HabitId find(const string& name) const {
+        shared_lock<shared_mutex> hold(lock);
+        return slots[probe(name, hashName(name))];
+    }
+
+    // Existing id for the name, or a new one.
+    HabitId intern(const string& name) {
+        uint32_t h = hashName(name);
+        {
+            shared_lock<shared_mutex> hold(lock);
+            HabitId known = slots[probe(name, h)];
+            if (known != NO_HABIT) return known;
+        }
+        unique_lock<shared_mutex> hold(lock);
+        size_t i = probe(name, h);   // again: another thread may have added it
+        if (slots[i] != NO_HABIT) return slots[i];
+        HabitId id = static_cast<HabitId>(names.size());
+        names.push_back(name);
+        hashes.push_back(h);
+        if (names.size() * 2 > slots.size()) grow();
+        else slots[i] = id;
+        return id;
+    }
+
+    const string& name(HabitId id) const {
+        shared_lock<shared_mutex> hold(lock);
+        return names[id];
+    }
+
+    size_t size() const {
+        shared_lock<shared_mutex> hold(lock);
+        return names.size();
+    }
+};
+
+// -------------------- WORKER POOL --------------------
+// Fixed set of threads for data-parallel loops. parallelFor splits [0, n)
+// into chunks that the workers and the calling thread claim from a shared
+// counter, so the caller always makes progress even if every worker is busy.
+class WorkerPool {
+private:
+    vector<thread> threads;
+    deque<function<void()>> tasks;
+    mutex lock;
+    condition_variable wake;
+    bool stopping = false;
+
+    void run() {
+        for (;;) {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t count) {
+        for (size_t i = 0; i < count; ++i) threads.emplace_back([this] { run(); });
+    }
+
+    ~WorkerPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    void submit(function<void()> task) {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Run body(begin, end) over [0, n) in chunks of `grain` and wait for all
+    // of them. Runs inline when there is only one chunk or no workers.
+    void parallelFor(size_t n, size_t grain, const function<void(size_t, size_t)>& body) {
+        size_t chunks = grain ? (n + grain - 1) / grain : 0;
+        if (chunks <= 1 || threads.empty()) {
+            if (n) body(0, n);
+            return;
+        }
+        struct Shared {
+            atomic<size_t> next{0};
+            size_t done = 0;
+            mutex m;
+            condition_variable finished;
+        };
+        auto shared = make_shared<Shared>();
+        // Helpers that start after the last chunk is claimed only touch
+        // `shared`, which they keep alive themselves.
+        auto work = [shared, n, grain, chunks, &body] {
+            size_t ran = 0;
+            for (size_t c; (c = shared->next.fetch_add(1)) < chunks; ++ran)
+                body(c * grain, min(n, (c + 1) * grain));
+            if (ran == 0) return;
+            lock_guard<mutex> guard(shared->m);
+            shared->done += ran;
+            if (shared->done == chunks) shared->finished.notify_all();
+        };
+        size_t helpers = min(threads.size(), chunks - 1);
+        for (size_t i = 0; i < helpers; ++i) submit(work);
+        work();
+        unique_lock<mutex> guard(shared->m);
+        shared->finished.wait(guard, [&] { return shared->done == chunks; });
+    }
+};
+
+// Process-wide pool, started on first use with one thread per spare core.
+WorkerPool& workerPool() {
+    static WorkerPool pool(max(1u, thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// -------------------- INFLUENCE PROPAGATION --------------------
+// Read-only view of HabitGraph's CSR arrays.
+struct CsrView {
+    const uint32_t* offsets;
+    const HabitId* targets;
+    const int* weights;
+    size_t nodes;
+};
+
+// Read-only view of HabitGraph's reverse index: the edges into v are
+// k in [offsets[v], offsets[v+1]), from sources[k] with weight weights[slots[k]].
+struct IncomingView {
+    const uint32_t* offsets;
+    const HabitId* sources;
+    const uint32_t* slots;
+    const int* weights;
+    size_t nodes;
+    const HabitIndex& names;
+};
+
+// Multi-hop influence via signed Katz centrality: a habit's score is the
+// weight of its own edges plus a decayed share of the scores of the habits
+// it feeds into,
+//     s = b + alpha * A s,   b[v] = sum of v's out-edge weights.
+// alpha is scaled by the largest absolute row sum, so the iteration is a
+// contraction and converges for any sign pattern. Every solve sweeps all
+// edges; it starts from the previous scores, which saves a couple of sweeps
+// after a small edit but is not an incremental update.
+class InfluencePropagation {
+private:
+    static constexpr double DECAY = 0.85;
+    static constexpr double TOLERANCE = 1e-9;
+    static constexpr int MAX_SWEEPS = 200;
+    static constexpr size_t PARALLEL_EDGES = 1 << 16;   // below this one thread is faster
+    static constexpr size_t GRAIN = 2048;                // rows per parallel chunk
+
+    vector<double> scores;
+    vector<double> next;
+
+public:
+    // Bring the scores up to date with the graph; returns the sweeps used.
+    // Targets need not be nodes (a habit joins the graph once marked), so
+    // the scores cover every target id; those without a row stay 0.
+    int solve(const CsrView& g) {
+        size_t n = g.nodes, m = n;
+        double maxAbsRow = 0;
+        for (size_t v = 0; v < n; ++v) {
+            double row = 0;
+            for (uint32_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+                row += abs(g.weights[i]);
+                m = max(m, size_t(g.targets[i]) + 1);
+            }
+            maxAbsRow = max(maxAbsRow, row);
+        }
+        scores.resize(m, 0.0);
+        next.resize(m, 0.0);
+        if (maxAbsRow == 0) {
+            fill(scores.begin(), scores.end(), 0.0);
+            return 0;
+        }
+        double alpha = DECAY / maxAbsRow;
+
+        auto sweep = [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                double sum = 0;
+                for (uint32_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i)
+                    sum += g.weights[i] * (1.0 + alpha * scores[g.targets[i]]);
+                next[v] = sum;
+            }
+        };
+        bool parallel = n > 0 && g.offsets[n] >= PARALLEL_EDGES;
+        int sweeps = 0;
+        while (sweeps < MAX_SWEEPS) {
+            ++sweeps;
+            if (parallel) workerPool().parallelFor(n, GRAIN, sweep);
+            else sweep(0, n);
+            double change = 0, scale = 1;
+            for (size_t v = 0; v < n; ++v) {
+                change = max(change, abs(next[v] - scores[v]));
+                scale = max(scale, abs(next[v]));
+            }
+            scores.swap(next);
+            if (change <= TOLERANCE * scale) break;
+        }
+        return sweeps;
     }
+
+    // Scores from the last solve, indexed by habit id.
+    const vector<double>& get() const { return scores; }
 };
 
 // -------------------- HABIT INFLUENCE GRAPH --------------------
+// Edges live in compressed sparse row form: the out-edges of habit id v are
+// targets/weights[offsets[v], offsets[v + 1]). New edges go to a small pending
+// buffer and are merged into the CSR arrays once it reaches MERGE_AT (or
+// before a whole-graph scan), so scans read contiguous memory while
+// addInfluence stays O(1) amortized.
+//
+// Each (from, to) pair is one edge: rows are kept sorted by target and
+// pending edges are hashed, so adding an existing relationship merges into
+// it (weights summed) in O(log d). Weights always stay within [-5, 5].
+//
+// Incoming edges are answered from a reverse CSR index (sources grouped by
+// target, each pointing at the forward slot that holds the weight). It is
+// rebuilt lazily after a merge or delete, and weight updates need no
+// bookkeeping because the weight lives only in the forward arrays.
+//
+// Every public method holds `guard`, so marks on different threads can
+// update the graph safely. It is recursive because public methods call each
+// other (the name overloads, exports).
+
 class HabitGraph {
 private:
-    map<string, vector<pair<string, int>>> adj;  // habit -> [(relatedHabit, weight)]
+    struct PendingEdge {
+        HabitId from;
+        HabitId to;
+        int weight;
+    };
+
+    static constexpr size_t MERGE_AT = 256;
+
+    HabitIndex& ids;
+    vector<char> present;   // id is a node of the graph
+    // Merging only changes the representation, so const scans may do it.
+    mutable vector<uint32_t> offsets;   // size present.size() + 1 once merged
+    mutable vector<HabitId> targets;
+    mutable vector<int> weights;
+    mutable vector<PendingEdge> pending;
+    mutable unordered_map<uint64_t, uint32_t> pendingSlot;   // (from, to) -> pending index
+
+    mutable vector<uint32_t> inOffsets;   // target id -> range of inSources/inSlots
+    mutable vector<HabitId> inSources;
+    mutable vector<uint32_t> inSlots;     // index into targets/weights
+    mutable bool reverseStale = true;
+
+    vector<int> outWeight;   // id -> sum of its out-edge weights
+    vector<int> heapPos;     // id -> slot in rank, -1 if not a node
+    vector<HabitId> rank;    // indexed max-heap on outWeight, ties to the lower id
+
+    mutable InfluencePropagation propagation;
+    mutable bool scoresStale = false;   // an edge or weight changed since the last solve
+
+    mutable recursive_mutex guard;
+
+    void ensureNode(HabitId id) {
+        if (id >= present.size()) {
+            present.resize(id + 1, 0);
+            outWeight.resize(id + 1, 0);
+            heapPos.resize(id + 1, -1);
+        }
+        if (present[id]) return;
+        present[id] = 1;
+        heapPos[id] = static_cast<int>(rank.size());
+        rank.push_back(id);
+        siftUp(heapPos[id]);
+    }
+
+    bool ranksAbove(HabitId a, HabitId b) const {
+        return outWeight[a] != outWeight[b] ? outWeight[a] > outWeight[b] : a < b;
+    }
+
+    void swapSlots(size_t i, size_t j) {
+        swap(rank[i], rank[j]);
+        heapPos[rank[i]] = static_cast<int>(i);
+        heapPos[rank[j]] = static_cast<int>(j);
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0 && ranksAbove(rank[i], rank[(i - 1) / 2])) {
+            swapSlots(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+    void siftDown(size_t i) {
+        for (;;) {
+            size_t best = i, l = 2 * i + 1, r = l + 1;
+            if (l < rank.size() && ranksAbove(rank[l], rank[best])) best = l;
+            if (r < rank.size() && ranksAbove(rank[r], rank[best])) best = r;
+            if (best == i) return;
+            swapSlots(i, best);
+            i = best;
+        }
+    }
+
+    void heapRemove(HabitId id) {
+        size_t i = heapPos[id];
+        swapSlots(i, rank.size() - 1);
+        rank.pop_back();
+        heapPos[id] = -1;
+        if (i < rank.size()) {
+            HabitId moved = rank[i];
+            siftUp(i);
+            siftDown(heapPos[moved]);
+        }
+    }
+
+    // Move a node to its new heap slot after its outWeight changed.
+    void addOutWeight(HabitId id, int change) {
+        if (change == 0) return;
+        outWeight[id] += change;
+        if (change > 0) siftUp(heapPos[id]);
+        else siftDown(heapPos[id]);
+    }
+
+    size_t rowBegin(HabitId v) const { return v + 1 < offsets.size() ? offsets[v] : targets.size(); }
+    size_t rowEnd(HabitId v) const { return v + 1 < offsets.size() ? offsets[v + 1] : targets.size(); }
+
+    static uint64_t edgeKey(HabitId from, HabitId to) { return (uint64_t(from) << 32) | to; }
+
+    static int clampWeight(int w) { return max(-5, min(5, w)); }
+
+    // Rebuild the CSR arrays with the pending edges added to their rows,
+    // keeping each row sorted by target.
+    void merge() const {
+        size_t n = present.size();
+        if (pending.empty() && offsets.size() == n + 1) return;
+        vector<uint32_t> next(n + 1, 0);
+        for (HabitId v = 0; v < n; ++v) next[v + 1] = static_cast<uint32_t>(rowEnd(v) - rowBegin(v));
+        for (const auto& e : pending) ++next[e.from + 1];
+        for (size_t v = 0; v < n; ++v) next[v + 1] += next[v];
+
+        vector<HabitId> t(next[n]);
+        vector<int> w(next[n]);
+        vector<uint32_t> fill(next.begin(), next.end() - 1);
+        for (HabitId v = 0; v < n; ++v) {
+            for (size_t i = rowBegin(v); i < rowEnd(v); ++i) {
+                t[fill[v]] = targets[i];
+                w[fill[v]++] = weights[i];
+            }
+        }
+        for (const auto& e : pending) {
+            t[fill[e.from]] = e.to;
+            w[fill[e.from]++] = e.weight;
+        }
+        vector<pair<HabitId, int>> row;
+        for (HabitId v = 0; v < n; ++v) {
+            if (next[v + 1] - next[v] == rowEnd(v) - rowBegin(v)) continue;  // no new edges
+            row.clear();
+            for (uint32_t i = next[v]; i < next[v + 1]; ++i) row.push_back({t[i], w[i]});
+            sort(row.begin(), row.end());
+            for (uint32_t i = next[v]; i < next[v + 1]; ++i) {
+                t[i] = row[i - next[v]].first;
+                w[i] = row[i - next[v]].second;
+            }
+        }
+        offsets.swap(next);
+        targets.swap(t);
+        weights.swap(w);
+        pending.clear();
+        pendingSlot.clear();
+        reverseStale = true;
+    }
+
+    // Rebuild the reverse index from the merged forward arrays.
+    void buildReverse() const {
+        merge();
+        if (!reverseStale) return;
+        size_t n = present.size();
+        for (HabitId t : targets) n = max(n, size_t(t) + 1);
+        inOffsets.assign(n + 1, 0);
+        for (HabitId t : targets) ++inOffsets[t + 1];
+        for (size_t v = 0; v < n; ++v) inOffsets[v + 1] += inOffsets[v];
+        inSources.resize(targets.size());
+        inSlots.resize(targets.size());
+        vector<uint32_t> fill(inOffsets.begin(), inOffsets.end() - 1);
+        for (HabitId v = 0; v < present.size(); ++v) {
+            for (size_t i = rowBegin(v); i < rowEnd(v); ++i) {
+                uint32_t k = fill[targets[i]]++;
+                inSources[k] = v;
+                inSlots[k] = static_cast<uint32_t>(i);
+            }
+        }
+        reverseStale = false;
+    }
+
+    // The weight of an existing (from, to) edge, or nullptr.
+    int* findEdge(HabitId from, HabitId to) {
+        auto first = targets.begin() + rowBegin(from), last = targets.begin() + rowEnd(from);
+        auto it = lower_bound(first, last, to);
+        if (it != last && *it == to) return &weights[it - targets.begin()];
+        auto slot = pendingSlot.find(edgeKey(from, to));
+        return slot == pendingSlot.end() ? nullptr : &pending[slot->second].weight;
+    }
+
+    // Visit the out-edges of one habit: fn(target, weight&).
+    template <class Fn>
+    void forEachOut(HabitId v, Fn&& fn) {
+        for (size_t i = rowBegin(v); i < rowEnd(v); ++i) fn(targets[i], weights[i]);
+        for (auto& e : pending)
+            if (e.from == v) fn(e.to, e.weight);
+    }
 
 public:
+    explicit HabitGraph(HabitIndex& index) : ids(index) {}
+
     void addHabit(const string& name) {
-        if (adj.find(name) == adj.end()) adj[name] = {};
+        lock_guard<recursive_mutex> hold(guard);
+        ensureNode(ids.intern(name));
     }
 
     void addInfluence(const string& from, const string& to, int weight = 2) {
-        adj[from].push_back({to, weight});
+        lock_guard<recursive_mutex> hold(guard);
+        addInfluence(ids.intern(from), ids.intern(to), weight);
     }
 
-    void updateInfluence(const string& habit, bool success, bool goodHabit, int motivation) {
+    void addInfluence(HabitId from, HabitId to, int weight = 2) {
+        lock_guard<recursive_mutex> hold(guard);
+        ensureNode(from);
+        scoresStale = true;
+        if (int* existing = findEdge(from, to)) {
+            int before = *existing;
+            *existing = clampWeight(before + weight);
+            addOutWeight(from, *existing - before);
+            return;
+        }
+        int clamped = clampWeight(weight);
+        pendingSlot[edgeKey(from, to)] = static_cast<uint32_t>(pending.size());
+        pending.push_back({from, to, clamped});
+        addOutWeight(from, clamped);
+        if (pending.size() >= MERGE_AT) merge();
+    }
+
+    void removeHabit(const string& name) {
+        lock_guard<recursive_mutex> hold(guard);
+        HabitId id = ids.find(name);
+        if (id != NO_HABIT) removeHabit(id);
+    }
+
+    // Drop a habit and every edge into or out of it.
+    void removeHabit(HabitId id) {
+        lock_guard<recursive_mutex> hold(guard);
+        buildReverse();
+        bool hasIn = id + 1 < inOffsets.size() && inOffsets[id + 1] > inOffsets[id];
+        bool isNode = id < present.size() && present[id];
+        if (!hasIn && !isNode) return;
+
+        for (uint32_t k = hasIn ? inOffsets[id] : 0; hasIn && k < inOffsets[id + 1]; ++k)
+            if (inSources[k] != id) addOutWeight(inSources[k], -weights[inSlots[k]]);
+        if (isNode) {
+            heapRemove(id);
+            outWeight[id] = 0;
+            present[id] = 0;
+        }
+
+        // compact the forward arrays in place, skipping edges that touch id
+        size_t n = present.size(), kept = 0;
+        vector<uint32_t> next(n + 1, 0);
+        for (HabitId v = 0; v < n; ++v) {
+            size_t begin = rowBegin(v), end = rowEnd(v);
+            next[v] = static_cast<uint32_t>(kept);
+            if (v == id) continue;
+            for (size_t i = begin; i < end; ++i) {
+                if (targets[i] == id) continue;
+                targets[kept] = targets[i];
+                weights[kept++] = weights[i];
+            }
+        }
+        next[n] = static_cast<uint32_t>(kept);
+        targets.resize(kept);
+        weights.resize(kept);
+        offsets.swap(next);
+        reverseStale = true;
+        scoresStale = true;
+    }
+
+    // Signed change one outcome applies to each of the habit's edge weights.
+    static int influenceStep(bool success, bool goodHabit, int motivation) {
         int delta = (motivation > 7) ? 2 : (motivation >= 4 ? 1 : 0);
         if (!goodHabit && success) delta *= -1;  // bad habit relapsed (adjust logic as intended)
+        return success ? delta : -delta;
+    }
 
-        // ensure habit exists in adjacency map
-        if (adj.find(habit) == adj.end()) adj[habit] = {};
+    void updateInfluence(const string& habit, bool success, bool goodHabit, int motivation) {
+        lock_guard<recursive_mutex> hold(guard);
+        updateInfluence(ids.intern(habit), success, goodHabit, motivation);
+    }
 
-        for (auto& edge : adj[habit]) {
-            int& w = edge.second;
-            w += (success ? delta : -delta);
-            w = max(-5, min(5, w)); // clamp weights between -5 and +5
-        }
+    void updateInfluence(HabitId habit, bool success, bool goodHabit, int motivation) {
+        lock_guard<recursive_mutex> hold(guard);
+        int step = influenceStep(success, goodHabit, motivation);
+        ensureNode(habit);
+        int change = 0;
+        forEachOut(habit, [step, &change](HabitId, int& w) {
+            int before = w;
+            w += step;
+            w = clampWeight(w); // clamp weights between -5 and +5
+            change += w - before;
+        });
+        addOutWeight(habit, change);
+        if (rowEnd(habit) > rowBegin(habit) || !pending.empty()) scoresStale = true;
+    }
+
+    // Same result as one updateInfluence per step, in order, but each edge
+    // is visited once for the whole run of steps.
+    void applyInfluenceSteps(HabitId habit, const vector<int>& steps) {
+        lock_guard<recursive_mutex> hold(guard);
+        ensureNode(habit);
+        int change = 0;
+        forEachOut(habit, [&steps, &change](HabitId, int& w) {
+            int before = w;
+            for (int step : steps) {
+                w += step;
+                w = clampWeight(w); // clamp weights between -5 and +5
+            }
+            change += w - before;
+        });
+        addOutWeight(habit, change);
+        if (rowEnd(habit) > rowBegin(habit) || !pending.empty()) scoresStale = true;
     }
 // public:
-        void exportToJsonFile(const std::string& filename) const {
+        void writeJson(ostream& out) const {
+            lock_guard<recursive_mutex> hold(guard);
+            merge();
             json j;
             j["edges"] = json::array();
             j["nodes"] = json::array();
 
-            // nodes: collect unique nodes
-            for (const auto& kv : adj) {
-                j["nodes"].push_back(kv.first);
+            // nodes, in id order
+            for (HabitId id = 0; id < present.size(); ++id) {
+                if (present[id]) j["nodes"].push_back(ids.name(id));
             }
             // edges
-            for (const auto& kv : adj) {
-                const string& src = kv.first;
-                for (const auto& p : kv.second) {
+            for (HabitId id = 0; id < present.size(); ++id) {
+                const string& src = ids.name(id);
+                for (size_t i = rowBegin(id); i < rowEnd(id); ++i) {
                     j["edges"].push_back({
                         {"source", src},
-                        {"target", p.first},
-                        {"weight", p.second}
+                        {"target", ids.name(targets[i])},
+                        {"weight", weights[i]}
                     });
                 }
             }
-            std::ofstream fout(filename);
-            if (fout) fout << j.dump(4);
+            out << j.dump(4);
         }
 
-    void showInfluences() const {
-        cout << "\n--- Habit Influence Network ---\n";
-        for (const auto& kv : adj) {
-            const string& src = kv.first;
-            const auto& edges = kv.second;
-            cout << src << " → ";
-            for (const auto& p : edges) {
-                const string& dst = p.first;
-                int w = p.second;
-                cout << "(" << dst << ", " << (w >= 0 ? "+" : "") << w << ") ";
+        void exportToJsonFile(const std::string& filename) const {
+            lock_guard<recursive_mutex> hold(guard);
+            if (!replaceFileAtomic(filename, [this](ostream& out) { writeJson(out); })) {
+                ++writeFailures;
+                cerr << "Warning: cannot write " << filename << '\n';
             }
-            cout << "\n";
         }
 
-        cout << "--------------------------------\n";
+    // Reads back a graph written by writeJson; false if missing or malformed.
+    bool loadJsonFile(const string& filename) {
+        lock_guard<recursive_mutex> hold(guard);
+        ifstream fin(filename);
+        if (!fin) return false;
+        json j = json::parse(fin, nullptr, false);
+        if (j.is_discarded() || !j.contains("nodes") || !j.contains("edges")) return false;
+        for (const auto& n : j["nodes"])
+            if (n.is_string()) addHabit(n.get<string>());
+        for (const auto& e : j["edges"]) {
+            if (!e.contains("source") || !e.contains("target") || !e.contains("weight")) continue;
+            addInfluence(e["source"].get<string>(), e["target"].get<string>(), e["weight"].get<int>());
+        }
+        return true;
     }
 
-    string getMostInfluential() const {
-        string best = "None";
-        int maxWeight = INT_MIN;
-        for (const auto& kv : adj) {
-            const string& src = kv.first;
-            const auto& edges = kv.second;
-            int total = 0;
-            for (const auto& e : edges) total += e.second;
-            if (total > maxWeight) {
-                maxWeight = total;
-                best = src;
+    void showInfluences(ostream& out = cout) const {
+        lock_guard<recursive_mutex> hold(guard);
+        merge();
+        out << "\n--- Habit Influence Network ---\n";
+        for (HabitId id = 0; id < present.size(); ++id) {
+            if (!present[id]) continue;
+            out << ids.name(id) << " → ";
+            for (size_t i = rowBegin(id); i < rowEnd(id); ++i) {
+                int w = weights[i];
+                out << "(" << ids.name(targets[i]) << ", " << (w >= 0 ? "+" : "") << w << ") ";
             }
+            out << "\n";
+        }
+
+        out << "--------------------------------\n";
+    }
+
+    // Habits with an edge into `habit`, with that edge's weight, in source id order.
+    vector<pair<string, int>> influencesOn(const string& habit) const {
+        lock_guard<recursive_mutex> hold(guard);
+        HabitId id = ids.find(habit);
+        return id == NO_HABIT ? vector<pair<string, int>>() : influencesOn(id);
+    }
+
+    vector<pair<string, int>> influencesOn(HabitId id) const {
+        lock_guard<recursive_mutex> hold(guard);
+        buildReverse();
+        vector<pair<string, int>> out;
+        if (id + 1 >= inOffsets.size()) return out;
+        for (uint32_t k = inOffsets[id]; k < inOffsets[id + 1]; ++k)
+            out.push_back({ids.name(inSources[k]), weights[inSlots[k]]});
+        return out;
+    }
+
+    // Runs fn with the graph locked, so fn may hand the view to other
+    // threads as long as it waits for them before returning.
+    void withIncoming(const function<void(const IncomingView&)>& fn) const {
+        lock_guard<recursive_mutex> hold(guard);
+        buildReverse();
+        fn({inOffsets.data(), inSources.data(), inSlots.data(), weights.data(), inOffsets.size() - 1, ids});
+    }
+
+    // The pointers stay valid until the graph next changes.
+    CsrView view() const {
+        lock_guard<recursive_mutex> hold(guard);
+        merge();
+        return {offsets.data(), targets.data(), weights.data(), present.size()};
+    }
+
+    // The n habits with the highest multi-hop (Katz) influence, best first.
+    // The scores are re-solved lazily, only when the graph changed.
+    vector<pair<string, double>> topPropagated(size_t n) const {
+        lock_guard<recursive_mutex> hold(guard);
+        if (scoresStale) {
+            propagation.solve(view());
+            scoresStale = false;
+        }
+        const vector<double>& score = propagation.get();
+        vector<HabitId> order;
+        for (HabitId id = 0; id < present.size(); ++id)
+            if (present[id]) order.push_back(id);
+        auto better = [&score](HabitId a, HabitId b) {
+            double sa = a < score.size() ? score[a] : 0, sb = b < score.size() ? score[b] : 0;
+            return sa != sb ? sa > sb : a < b;
+        };
+        n = min(n, order.size());
+        partial_sort(order.begin(), order.begin() + n, order.end(), better);
+        vector<pair<string, double>> out;
+        for (size_t i = 0; i < n; ++i)
+            out.push_back({ids.name(order[i]), order[i] < score.size() ? score[order[i]] : 0});
+        return out;
+    }
+
+    // Habit with the largest total outgoing weight, read off the heap top.
+    string getMostInfluential() const {
+        lock_guard<recursive_mutex> hold(guard);
+        return rank.empty() ? "None" : ids.name(rank[0]);
+    }
+
+    // The n highest-ranked habits with their total outgoing weight, best
+    // first. Walks the heap best-first, so it costs O(n log n) however large
+    // the graph is.
+    vector<pair<string, int>> topInfluential(size_t n) const {
+        lock_guard<recursive_mutex> hold(guard);
+        vector<pair<string, int>> out;
+        auto worse = [this](size_t a, size_t b) { return ranksAbove(rank[b], rank[a]); };
+        priority_queue<size_t, vector<size_t>, decltype(worse)> frontier(worse);
+        if (!rank.empty()) frontier.push(0);
+        while (!frontier.empty() && out.size() < n) {
+            size_t i = frontier.top();
+            frontier.pop();
+            out.push_back({ids.name(rank[i]), outWeight[rank[i]]});
+            if (2 * i + 1 < rank.size()) frontier.push(2 * i + 1);
+            if (2 * i + 2 < rank.size()) frontier.push(2 * i + 2);
         }
-        return best;
+        return out;
     }
 };
 
 // --------------------- FORWARD / DECLARATIONS ------------------------
-void logActivity(const string& username, const string& habitName);
-void viewLogs();
+void viewLogs(class ActivityLogger& logger);
 void saveHabitsToFile(const vector<class Habit>&, const string&);
 
 // --------------------- HABIT CLASS ----------------------------------
@@ -210,45 +1049,80 @@ private:
     int streak;
     bool completedToday;
     bool isGood; // new: distinguishes Good vs Bad habit
-    static int totalHabits;
+    static atomic<int> totalHabits;   // live habits across all tenants and threads
     HabitTree progressTree;  // new: track 21-day formation
+    HabitId id;              // assigned by the tracker from the shared HabitIndex
 public:
     Habit(const string& n = "Unnamed", int s = 0, bool good = true)
-        : name(n), streak(s), completedToday(false), isGood(good) {
+        : name(n), streak(s), completedToday(false), isGood(good), id(NO_HABIT) {
+        ++totalHabits;
+    }
+
+    // Habits own their progress history, so they move instead of copying.
+    Habit(const Habit&) = delete;
+    Habit& operator=(const Habit&) = delete;
+    Habit(Habit&& other) noexcept
+        : name(std::move(other.name)), streak(other.streak), completedToday(other.completedToday),
+          isGood(other.isGood), progressTree(std::move(other.progressTree)), id(other.id) {
         ++totalHabits;
     }
+    Habit& operator=(Habit&&) noexcept = default;
 
     ~Habit() { --totalHabits; }
 
-    void markComplete(int motivation) {
-        if (completedToday) {
+    // Records today's outcome without console output; false if already marked.
+    bool mark(bool success, int motivation) {
+        if (completedToday) return false;
+        completedToday = true;
+        if (success) ++streak;
+        progressTree.insert(success, motivation);
+        return true;
+    }
+
+    // Returns false when the habit was already marked today.
+    bool markComplete(int motivation) {
+        if (!mark(true, motivation)) {
             cout << "Habit \"" << name << "\" already marked complete for today.\n";
-            return;
+            return false;
         }
-        completedToday = true;
-        ++streak;
-        progressTree.insert(true, motivation);
         cout << "✅ Great job! You completed: " << name << " (Streak: " << streak << ")\n";
+        return true;
     }
     // in Habit public methods:
-        void exportProgressJson(const std::string& folder = ".") const {
+        std::string progressJsonPath(const std::string& folder = ".") const {
             // sanitize file name if you want; simple version:
             std::string fname = folder + "/" + getName() + "_tree.json";
             // replace spaces with underscores
             std::replace(fname.begin(), fname.end(), ' ', '_');
-            // call HabitTree exporter — need a const-export method in HabitTree (we added it)
-            const_cast<HabitTree&>(progressTree).exportToJsonFile(fname); // const_cast because method not const? If method is const above, no need.
+            return fname;
+        }
+
+        void exportProgressJson(const std::string& folder = ".") const {
+            progressTree.exportToJsonFile(progressJsonPath(folder));
         }
 
 
-    void markMissed(int motivation) {
-        if (completedToday) {
+    bool markMissed(int motivation) {
+        if (!mark(false, motivation)) {
             cout << "Habit \"" << name << "\" already marked complete for today.\n";
-            return;
+            return false;
         }
-        completedToday = true;
-        progressTree.insert(false, motivation);
         cout << "⚠️ You missed: " << name << " today.\n";
+        return true;
+    }
+
+    // Persistence hooks: no console output and no once-per-day guard.
+    void restoreDay(uint32_t day, bool success, int motivation) {
+        progressTree.restore(day, success, motivation);
+    }
+    // Records one more day regardless of today's mark (bulk backfills).
+    void backfill(bool success, int motivation) {
+        if (success) ++streak;
+        progressTree.insert(success, motivation);
+    }
+    void replayMark(uint32_t day, bool success, int motivation) {
+        if (success) ++streak;
+        progressTree.restore(day, success, motivation);
     }
 
     void resetDay() { completedToday = false; }
@@ -260,10 +1134,13 @@ public:
              << " | Today: " << (completedToday ? "YES" : "NO") << '\n';
     }
 
-    string getName() const { return name; }
+    const string& getName() const { return name; }
     int getStreak() const { return streak; }
     bool isDone() const { return completedToday; }
     bool isGoodHabit() const { return isGood; }
+    const HabitTree& getTree() const { return progressTree; }
+    HabitId getId() const { return id; }
+    void setId(HabitId i) { id = i; }
 
     void getProgress(double& formation, double& avgMotivation, int& success, int& fail) const {
         progressTree.getStats(formation, avgMotivation, success, fail);
@@ -273,8 +1150,16 @@ public:
 
     friend void saveHabitsToFile(const vector<Habit>& habits, const string& filename);
 };
-int Habit::totalHabits = 0;
+atomic<int> Habit::totalHabits{0};
+
 
+// One outcome for bulk ingestion; when == 0 means "now".
+struct MarkEvent {
+    string habit;
+    bool success = true;
+    int motivation = 5;
+    time_t when = 0;
+};
 
 ostream& operator<<(ostream& os, const Habit& h) {
     os << h.getName() << " (" << h.getStreak() << " days)";
@@ -293,44 +1178,1472 @@ public:
     }
 };
 
-// --------------------- HABIT TRACKER --------------------------------
-class HabitTracker : public User {
-private:
-    vector<Habit> habits;
+// --------------------- MARK JOURNAL ---------------------------------
+// Append-only binary journal of habit events. Records are buffered and
+// fsync'ed in groups; snapshot + journal tail rebuilds the tracker state.
+// The file starts with "HJNL" and a generation number. Each compaction
+// stamps the snapshot with the next generation before truncating the
+// journal, so a journal older than its snapshot (a crash between the two)
+// is recognised and not replayed twice. Journals without the header are
+// generation 0.
+enum class JournalOp : uint8_t { Add = 1, Mark = 2, Delete = 3 };
 
-public:
-    HabitTracker(const string& name = "Guest") : User(name) {}
+struct JournalRecord {
+    JournalOp op = JournalOp::Mark;
+    int64_t timestamp = 0;
+    uint32_t habitIndex = 0;   // position in the habit list when the event happened
+    uint32_t day = 0;
+    bool success = false;      // Mark: done/missed, Add: good habit
+    uint8_t motivation = 0;
+    string name;
+};
 
-    // Add habit by name
-    void addHabit(const string& name) {
-        habits.emplace_back(name, 0);
-        cout << "Habit added: " << name << '\n';
+// FNV-1a, used to reject torn or corrupted journal records on replay.
+uint32_t checksum32(const char* data, size_t len, uint32_t h = 2166136261u) {
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
     }
+    return h;
+}
 
+template <class T>
+void putRaw(string& buf, const T& v) { buf.append(reinterpret_cast<const char*>(&v), sizeof(T)); }
 
-    // Interactive add habit (uses getline)
-   void addHabitInteractive() {
-            cout << "Enter habit name: ";
-            string name;
-            getline(cin, name);
-            if (name.empty()) {
-                cout << "Habit name cannot be empty.\n";
-                return;
-            }
+template <class T>
+bool getRaw(istream& in, T& v) { return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T))); }
 
-            cout << "Is this a Good habit or a Bad habit? (G/B): ";
+// Flush stdio buffers and force the file contents to disk.
+void syncFile(FILE* f) {
+    fflush(f);
+#ifdef _WIN32
+    _commit(_fileno(f));
+#else
+    fsync(fileno(f));
+#endif
+}
+
+class HabitJournal {
+private:
+    static constexpr size_t HEADER_SIZE = 8;   // "HJNL" + uint32_t generation
+
+    string path;
+    string pending;
+    size_t pendingRecords;
+    size_t groupSize;
+    size_t recordCount;   // records in the file since the last snapshot
+    uint32_t generation;
+    bool holding;         // bulk ingestion: one commit at the end
+
+    // Reads the header; false for a headerless (generation 0) journal.
+    static bool readHeader(istream& in, uint32_t& gen) {
+        char magic[4];
+        if (!in.read(magic, 4) || memcmp(magic, "HJNL", 4) != 0 || !getRaw(in, gen)) {
+            in.clear();
+            in.seekg(0);
+            gen = 0;
+            return false;
+        }
+        return true;
+    }
+
+    // Starts the file with a header: "wb" truncates, "ab" fills an empty file.
+    void writeHeader(const char* mode) {
+        FILE* f = fopen(path.c_str(), mode);
+        if (!f) {
+            ++writeFailures;
+            cerr << "Warning: cannot open journal " << path << '\n';
+            return;
+        }
+        string hdr("HJNL");
+        putRaw(hdr, generation);
+        fwrite(hdr.data(), 1, hdr.size(), f);
+        syncFile(f);
+        fclose(f);
+    }
+
+public:
+    // The file is opened per commit rather than held open, so many loaded
+    // tenants do not each pin a descriptor.
+    explicit HabitJournal(const string& p, size_t group = 64)
+        : path(p), pendingRecords(0), groupSize(group), recordCount(0), generation(0), holding(false) {
+        {
+            ifstream fin(path, ios::binary);
+            if (fin) readHeader(fin, generation);
+        }
+        std::error_code ec;
+        if (!filesystem::exists(path, ec) || filesystem::file_size(path, ec) == 0) writeHeader("ab");
+    }
+
+    ~HabitJournal() { commit(); }
+
+    HabitJournal(const HabitJournal&) = delete;
+    HabitJournal& operator=(const HabitJournal&) = delete;
+
+    // Layout: op, timestamp, index, day, success, motivation, name length,
+    // name bytes, checksum of everything before it.
+    void append(const JournalRecord& r) {
+        size_t start = pending.size();
+        putRaw(pending, static_cast<uint8_t>(r.op));
+        putRaw(pending, r.timestamp);
+        putRaw(pending, r.habitIndex);
+        putRaw(pending, r.day);
+        putRaw(pending, static_cast<uint8_t>(r.success));
+        putRaw(pending, r.motivation);
+        putRaw(pending, static_cast<uint16_t>(min<size_t>(r.name.size(), UINT16_MAX)));
+        pending.append(r.name, 0, min<size_t>(r.name.size(), UINT16_MAX));
+        putRaw(pending, checksum32(pending.data() + start, pending.size() - start));
+        ++recordCount;
+        if (++pendingRecords >= groupSize && !holding) commit();
+    }
+
+    // While held, records only accumulate; the caller commits once.
+    void holdCommits(bool hold) { holding = hold; }
+
+    // Group commit: one write and one fsync for every buffered record.
+    void commit() {
+        if (pending.empty()) return;
+        FILE* file = fopen(path.c_str(), "ab");
+        if (!file) {
+            ++writeFailures;
+            cerr << "Warning: cannot open journal " << path << '\n';
+            return;   // kept pending; retried on the next commit
+        }
+        if (fwrite(pending.data(), 1, pending.size(), file) != pending.size()) {
+            ++writeFailures;
+            cerr << "Warning: journal write failed.\n";
+        }
+        syncFile(file);
+        fclose(file);
+        pending.clear();
+        pendingRecords = 0;
+    }
+
+    size_t size() const { return recordCount; }
+    uint32_t getGeneration() const { return generation; }
+
+    // Drop every record and start generation `gen`; called once a snapshot
+    // stamped with `gen` holds the same state.
+    void reset(uint32_t gen) {
+        pending.clear();
+        pendingRecords = 0;
+        recordCount = 0;
+        generation = gen;
+        writeHeader("wb");
+    }
+
+    // Replays complete records in order; a torn or corrupt tail ends the
+    // replay and is cut off, so later appends are not stranded behind it. A
+    // journal from before generation `covered` is already folded into the
+    // snapshot: it is skipped and restarted at `covered`.
+    size_t replay(uint32_t covered, const function<void(const JournalRecord&)>& apply) {
+        ifstream fin(path, ios::binary);
+        if (fin) readHeader(fin, generation);
+        if (generation < covered) {
+            cerr << "Warning: journal " << path << " is older than the snapshot; skipping it.\n";
+            reset(covered);
+            return 0;
+        }
+        uint64_t good = fin ? static_cast<uint64_t>(fin.tellg()) : 0;   // end of the last intact record
+        size_t replayed = 0;
+        while (fin) {
+            string raw;
+            JournalRecord r;
+            uint8_t op = 0, success = 0;
+            uint16_t len = 0;
+            uint32_t sum = 0;
+            if (!getRaw(fin, op) || !getRaw(fin, r.timestamp) || !getRaw(fin, r.habitIndex) ||
+                !getRaw(fin, r.day) || !getRaw(fin, success) || !getRaw(fin, r.motivation) ||
+                !getRaw(fin, len))
+                break;
+            r.name.resize(len);
+            if (len && !fin.read(&r.name[0], len)) break;
+            if (!getRaw(fin, sum)) break;
+            putRaw(raw, op);
+            putRaw(raw, r.timestamp);
+            putRaw(raw, r.habitIndex);
+            putRaw(raw, r.day);
+            putRaw(raw, success);
+            putRaw(raw, r.motivation);
+            putRaw(raw, len);
+            raw += r.name;
+            if (checksum32(raw.data(), raw.size()) != sum) {
+                cerr << "Warning: journal " << path << " has a corrupt record; ignoring the rest.\n";
+                break;
+            }
+            r.op = static_cast<JournalOp>(op);
+            r.success = success != 0;
+            apply(r);
+            ++replayed;
+            good = static_cast<uint64_t>(fin.tellg());
+        }
+        fin.close();
+        recordCount += replayed;
+        std::error_code ec;
+        if (filesystem::exists(path, ec) && filesystem::file_size(path, ec) > good) {
+            filesystem::resize_file(path, good, ec);
+            if (ec) {
+                ++writeFailures;
+                cerr << "Warning: cannot truncate journal " << path << ": " << ec.message() << '\n';
+            }
+#ifdef HABIT_DEBUG
+            assert(ec || filesystem::file_size(path, ec) == good);
+#endif
+        }
+        return replayed;
+    }
+};
+
+// --------------------- SNAPSHOT FILE --------------------------------
+// Versioned binary snapshot laid out for mmap: a header, fixed-size habit
+// records, day columns shared by all habits, then a string table of names.
+const uint32_t SNAPSHOT_VERSION = 2;
+
+struct SnapshotHeader {
+    char magic[4];            // "HSNP"
+    uint32_t version;
+    uint32_t habitCount;
+    uint32_t journalGeneration; // journal generations below this are included
+    uint64_t dayCount;        // entries in each day column
+    uint64_t recordsOffset;   // SnapshotHabit[habitCount]
+    uint64_t daysOffset;      // uint32_t[dayCount]
+    uint64_t successOffset;   // uint8_t[dayCount]
+    uint64_t motivationOffset;// uint8_t[dayCount]
+    uint64_t stringsOffset;   // concatenated names, no terminators
+    uint64_t stringsSize;
+};
+
+struct SnapshotHabit {
+    static constexpr uint32_t GOOD = 1;
+    uint32_t nameOffset;      // into the string table
+    uint32_t nameLength;
+    int32_t streak;
+    uint32_t flags;
+    uint64_t firstDay;        // first entry of this habit in the day columns
+    uint32_t dayCount;
+    uint32_t reserved;
+};
+
+// Read-only view of a whole file: mmap'ed on POSIX, read into memory elsewhere.
+class MappedFile {
+private:
+    const char* ptr;
+    size_t len;
+#ifdef _WIN32
+    vector<char> buffer;
+#endif
+
+public:
+    explicit MappedFile(const string& path) : ptr(nullptr), len(0) {
+#ifdef _WIN32
+        ifstream fin(path, ios::binary | ios::ate);
+        if (!fin) return;
+        buffer.resize(static_cast<size_t>(fin.tellg()));
+        fin.seekg(0);
+        if (!buffer.empty() && fin.read(buffer.data(), buffer.size())) {
+            ptr = buffer.data();
+            len = buffer.size();
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ptr = static_cast<const char*>(p);
+                len = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (ptr) munmap(const_cast<char*>(ptr), len);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+};
+
+// Bounds-checked accessors over a mapped snapshot; nothing is copied.
+class SnapshotView {
+private:
+    const char* base;
+    size_t len;
+    const SnapshotHeader* hdr;
+
+    bool inside(uint64_t offset, uint64_t bytes) const { return offset <= len && bytes <= len - offset; }
+
+public:
+    SnapshotView(const char* data, size_t size) : base(data), len(size), hdr(nullptr) {
+        if (size < sizeof(SnapshotHeader)) return;
+        const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(data);
+        if (memcmp(h->magic, "HSNP", 4) != 0 || h->version != SNAPSHOT_VERSION) return;
+        hdr = h;
+        // dayCount is checked against len first so the multiply cannot wrap.
+        if (h->dayCount > len / sizeof(uint32_t) ||
+            !inside(h->recordsOffset, uint64_t(h->habitCount) * sizeof(SnapshotHabit)) ||
+            !inside(h->daysOffset, h->dayCount * sizeof(uint32_t)) || !inside(h->successOffset, h->dayCount) ||
+            !inside(h->motivationOffset, h->dayCount) || !inside(h->stringsOffset, h->stringsSize) ||
+            h->recordsOffset % alignof(SnapshotHabit) != 0 || h->daysOffset % alignof(uint32_t) != 0) {
+            hdr = nullptr;
+            return;
+        }
+        for (uint32_t i = 0; i < h->habitCount; ++i) {
+            const SnapshotHabit& r = habit(i);
+            if (uint64_t(r.nameOffset) + r.nameLength > h->stringsSize ||
+                r.dayCount > h->dayCount || r.firstDay > h->dayCount - r.dayCount) {
+                hdr = nullptr;
+                return;
+            }
+        }
+    }
+
+    bool valid() const { return hdr != nullptr; }
+    uint32_t habitCount() const { return hdr->habitCount; }
+    uint32_t journalGeneration() const { return hdr->journalGeneration; }
+    const SnapshotHabit& habit(uint32_t i) const {
+        return reinterpret_cast<const SnapshotHabit*>(base + hdr->recordsOffset)[i];
+    }
+    const char* name(const SnapshotHabit& r) const { return base + hdr->stringsOffset + r.nameOffset; }
+    const uint32_t* days(const SnapshotHabit& r) const {
+        return reinterpret_cast<const uint32_t*>(base + hdr->daysOffset) + r.firstDay;
+    }
+    const uint8_t* success(const SnapshotHabit& r) const {
+        return reinterpret_cast<const uint8_t*>(base + hdr->successOffset) + r.firstDay;
+    }
+    const uint8_t* motivation(const SnapshotHabit& r) const {
+        return reinterpret_cast<const uint8_t*>(base + hdr->motivationOffset) + r.firstDay;
+    }
+};
+
+// --------------------- BACKGROUND WRITER ----------------------------
+// Opt-in (--async-io) thread that performs log appends and dashboard
+// exports, so marking a habit never waits on the disk. The menu thread is
+// the only producer, which lets the hand-off be a lock-free SPSC ring.
+template <class T>
+class SpscQueue {
+private:
+    vector<T> slots;
+    atomic<size_t> head;   // next slot to pop, owned by the consumer
+    atomic<size_t> tail;   // next slot to push, owned by the producer
+
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity + 1), head(0), tail(0) {}
+
+    bool push(T&& item) {
+        size_t t = tail.load(memory_order_relaxed);
+        size_t next = (t + 1) % slots.size();
+        if (next == head.load(memory_order_acquire)) return false;   // full
+        slots[t] = std::move(item);
+        tail.store(next, memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;      // empty
+        item = std::move(slots[h]);
+        head.store((h + 1) % slots.size(), memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(memory_order_acquire) == tail.load(memory_order_acquire); }
+};
+
+struct WriteJob {
+    enum Kind { Append, Replace, Close } kind = Append;   // Close: release an append handle
+    string path;
+    string payload;
+};
+
+// Performs a job on the calling thread; also the fallback once the
+// background writer has been drained.
+void runWriteJob(const WriteJob& job) {
+    if (job.kind == WriteJob::Close) return;
+    if (job.kind == WriteJob::Replace) {
+        if (!replaceFileAtomic(job.path, [&job](ostream& out) { out.write(job.payload.data(), job.payload.size()); })) {
+            ++writeFailures;
+            cerr << "Warning: cannot write " << job.path << '\n';
+        }
+        return;
+    }
+    ofstream fout(job.path, ios::binary | ios::app);
+    if (fout) fout.write(job.payload.data(), job.payload.size());
+    if (!fout) {
+        ++writeFailures;
+        cerr << "Warning: cannot write " << job.path << '\n';
+    }
+}
+
+class BackgroundWriter {
+private:
+    SpscQueue<WriteJob> queue;
+    atomic<bool> stopping;
+    atomic<bool> stopped;
+    size_t submitted;            // producer side only
+    atomic<size_t> completed;
+    thread worker;
+
+    // Log files stay open between jobs, but at most MAX_OPEN of them: past
+    // that the least recently used handle (found by a scan) is closed.
+    static constexpr size_t MAX_OPEN = 16;
+
+    struct AppendFile {
+        FILE* file;
+        uint64_t lastUse;
+    };
+
+    void run() {
+        unordered_map<string, AppendFile> appendFiles;
+        uint64_t uses = 0;
+        auto closeFile = [&appendFiles](unordered_map<string, AppendFile>::iterator it) {
+            fclose(it->second.file);
+            appendFiles.erase(it);
+        };
+        WriteJob job;
+        int idle = 0;
+        while (true) {
+            if (queue.pop(job)) {
+                idle = 0;
+                if (job.kind == WriteJob::Append) {
+                    auto it = appendFiles.find(job.path);
+                    if (it == appendFiles.end()) {
+                        if (appendFiles.size() >= MAX_OPEN)
+                            closeFile(min_element(appendFiles.begin(), appendFiles.end(), [](const auto& a, const auto& b) {
+                                return a.second.lastUse < b.second.lastUse;
+                            }));
+                        if (FILE* f = fopen(job.path.c_str(), "ab")) it = appendFiles.emplace(job.path, AppendFile{f, 0}).first;
+                    }
+                    if (it != appendFiles.end() &&
+                        fwrite(job.payload.data(), 1, job.payload.size(), it->second.file) == job.payload.size()) {
+                        it->second.lastUse = ++uses;
+                    } else {
+                        ++writeFailures;
+                        cerr << "Warning: cannot write " << job.path << '\n';
+                    }
+                } else if (job.kind == WriteJob::Close) {
+                    auto it = appendFiles.find(job.path);
+                    if (it != appendFiles.end()) closeFile(it);
+                } else {
+                    runWriteJob(job);
+                }
+                if (queue.empty()) {
+                    for (auto& kv : appendFiles) fflush(kv.second.file);
+                }
+                completed.fetch_add(1, memory_order_release);
+                continue;
+            }
+            if (stopping.load(memory_order_acquire) && queue.empty()) break;
+            // back off while idle: spin briefly, then sleep up to 5 ms
+            if (idle < 64) {
+                ++idle;
+                this_thread::yield();
+            } else {
+                this_thread::sleep_for(chrono::milliseconds(5));
+            }
+        }
+        for (auto& kv : appendFiles) fclose(kv.second.file);
+    }
+
+public:
+    explicit BackgroundWriter(size_t capacity = 4096)
+        : queue(capacity), stopping(false), stopped(false), submitted(0), completed(0),
+          worker(&BackgroundWriter::run, this) {}
+
+    ~BackgroundWriter() { drain(); }
+
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+    // Hands the job to the writer thread; waits only if the queue is full.
+    void submit(WriteJob job) {
+        if (stopped.load(memory_order_acquire)) {
+            runWriteJob(job);
+            return;
+        }
+        while (!queue.push(std::move(job))) this_thread::yield();
+        ++submitted;
+    }
+
+    // Blocks until every submitted job has reached the disk, e.g. before
+    // reading log.txt back.
+    void waitIdle() {
+        while (!stopped.load(memory_order_acquire) && completed.load(memory_order_acquire) != submitted)
+            this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    // Writes everything queued so far and stops the thread.
+    void drain() {
+        if (stopped.exchange(true)) return;
+        stopping.store(true, memory_order_release);
+        worker.join();
+    }
+};
+
+// --------------------- ACTIVITY LOGGER ------------------------------
+// Activity is stored as fixed-size binary records in log.bin; user and
+// habit names are interned once in log.strings. The human text layout of
+// the old log.txt is only produced when viewing or exporting.
+struct LogEntry {
+    time_t when = 0;
+    string user;
+    string habit;
+    bool success = true;
+    int motivation = 0;
+};
+
+tm localTime(time_t when) {
+    tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &when);
+#else
+    localtime_r(&when, &local);
+#endif
+    return local;
+}
+
+// Calendar day as YYYYMMDD, the key used by the log index.
+int32_t dayKey(const tm& t) { return (t.tm_year + 1900) * 10000 + (t.tm_mon + 1) * 100 + t.tm_mday; }
+
+// Same layout as ctime() ("Sun Nov 09 15:11:30 2025"), without its static buffer.
+string formatTimestamp(time_t when) {
+    tm local = localTime(when);
+    char buf[32];
+    size_t n = strftime(buf, sizeof(buf), "%a %b %d %H:%M:%S %Y", &local);
+    return string(buf, n);
+}
+
+// Parses a text log line, "[Sun Nov 09 15:11:30 2025] Harsh completed habit: dancing".
+bool parseLogLine(const string& line, LogEntry& e) {
+    static const string done = " completed habit: ", missed = " missed habit: ";
+    size_t close = line.find(']');
+    if (line.empty() || line[0] != '[' || close == string::npos) return false;
+    tm t = {};
+    istringstream ts(line.substr(1, close - 1));
+    ts >> get_time(&t, "%a %b %d %H:%M:%S %Y");
+    if (ts.fail()) return false;
+    t.tm_isdst = -1;
+    e.when = mktime(&t);
+    size_t pos = line.find(done, close);
+    size_t skip = done.size();
+    e.success = true;
+    if (pos == string::npos) {
+        pos = line.find(missed, close);
+        skip = missed.size();
+        e.success = false;
+    }
+    if (pos == string::npos) return false;
+    size_t userStart = min(close + 2, pos);
+    e.user = line.substr(userStart, pos - userStart);
+    e.habit = line.substr(pos + skip);
+    e.motivation = 0;   // not recorded by the text format
+    return true;
+}
+
+struct LogRecord {
+    int64_t when = 0;      // epoch seconds
+    uint32_t user = 0;     // string id
+    uint32_t habit = 0;    // string id
+    uint8_t outcome = 0;   // 1 = completed, 0 = missed
+    uint8_t motivation = 0;
+};
+
+const size_t LOG_RECORD_SIZE = 20;   // packed: 8 + 4 + 4 + 1 + 1 + 2 reserved
+
+void encodeLogRecord(string& buf, const LogRecord& r) {
+    putRaw(buf, r.when);
+    putRaw(buf, r.user);
+    putRaw(buf, r.habit);
+    putRaw(buf, r.outcome);
+    putRaw(buf, r.motivation);
+    putRaw(buf, static_cast<uint16_t>(0));
+}
+
+LogRecord decodeLogRecord(const char* p) {
+    LogRecord r;
+    memcpy(&r.when, p, 8);
+    memcpy(&r.user, p + 8, 4);
+    memcpy(&r.habit, p + 12, 4);
+    r.outcome = static_cast<uint8_t>(p[16]);
+    r.motivation = static_cast<uint8_t>(p[17]);
+    return r;
+}
+
+// Append-only string table: a string's id is its position in the file,
+// stored as a uint32 length followed by the bytes.
+class LogStrings {
+private:
+    vector<string> names;
+    unordered_map<string, uint32_t> ids;
+    string pending;   // encoded strings not yet written
+
+public:
+    void load(const string& path) {
+        ifstream fin(path, ios::binary);
+        uint32_t len = 0;
+        while (fin && getRaw(fin, len)) {
+            string s(len, '\0');
+            if (len && !fin.read(&s[0], len)) break;
+            ids.emplace(s, static_cast<uint32_t>(names.size()));
+            names.push_back(std::move(s));
+        }
+    }
+
+    uint32_t intern(const string& s) {
+        auto it = ids.find(s);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids.emplace(s, id);
+        names.push_back(s);
+        putRaw(pending, static_cast<uint32_t>(s.size()));
+        pending += s;
+        return id;
+    }
+
+    bool find(const string& s, uint32_t& id) const {
+        auto it = ids.find(s);
+        if (it == ids.end()) return false;
+        id = it->second;
+        return true;
+    }
+
+    const string& name(uint32_t id) const {
+        static const string unknown = "?";
+        return id < names.size() ? names[id] : unknown;
+    }
+
+    string takePending() {
+        string out;
+        out.swap(pending);
+        return out;
+    }
+};
+
+// In-memory postings over log.bin. Records are fixed-size, so record n
+// lives at n * LOG_RECORD_SIZE; per-day and per-habit postings let paging,
+// tail and filter queries touch only the records they return.
+class LogIndex {
+private:
+    string binPath;
+    string stringsPath;
+    LogStrings strings;
+    size_t count;
+    map<int32_t, vector<uint32_t>> byDay;
+    unordered_map<uint32_t, vector<uint32_t>> byHabit;
+    // the last local day resolved, so a scan calls localtime once per day
+    int64_t dayStart, dayEnd;
+    int32_t lastDay;
+
+    int32_t dayOf(int64_t when) {
+        if (when < dayStart || when >= dayEnd) {
+            tm t = localTime(static_cast<time_t>(when));
+            lastDay = dayKey(t);
+            t.tm_hour = t.tm_min = t.tm_sec = 0;
+            t.tm_isdst = -1;
+            dayStart = mktime(&t);
+            t.tm_mday += 1;
+            t.tm_isdst = -1;
+            dayEnd = mktime(&t);
+        }
+        return lastDay;
+    }
+
+public:
+    LogIndex(const string& bin, const string& strs)
+        : binPath(bin), stringsPath(strs), count(0), dayStart(0), dayEnd(0), lastDay(0) {}
+
+    const string& path() const { return binPath; }
+    const string& stringsFile() const { return stringsPath; }
+    LogStrings& names() { return strings; }
+    const LogStrings& names() const { return strings; }
+
+    // Reads the string table and cuts a torn trailing record off log.bin so
+    // appends stay aligned. This is all that writing needs.
+    void open() {
+        strings.load(stringsPath);
+        std::error_code ec;
+        if (!filesystem::exists(binPath, ec)) return;
+        uint64_t size = filesystem::file_size(binPath, ec);
+        if (!ec && size % LOG_RECORD_SIZE) filesystem::resize_file(binPath, size - size % LOG_RECORD_SIZE, ec);
+    }
+
+    // Builds the postings by scanning log.bin once; call after open().
+    void scan() {
+        ifstream fin(binPath, ios::binary);
+        vector<char> chunk(LOG_RECORD_SIZE * 4096);
+        while (fin) {
+            fin.read(chunk.data(), chunk.size());
+            size_t got = static_cast<size_t>(fin.gcount());
+            for (size_t off = 0; off + LOG_RECORD_SIZE <= got; off += LOG_RECORD_SIZE)
+                add(decodeLogRecord(chunk.data() + off));
+        }
+    }
+
+    void add(const LogRecord& r) {
+        uint32_t n = static_cast<uint32_t>(count++);
+        byDay[dayOf(r.when)].push_back(n);
+        byHabit[r.habit].push_back(n);
+    }
+
+    size_t lineCount() const { return count; }
+
+    // Records [first, first + n) in file order.
+    vector<uint32_t> range(size_t first, size_t n) const {
+        vector<uint32_t> out;
+        for (size_t i = first; i < count && i < first + n; ++i) out.push_back(static_cast<uint32_t>(i));
+        return out;
+    }
+
+    // Records dated within [from, to] (YYYYMMDD, inclusive), optionally for one habit.
+    vector<uint32_t> query(int32_t from, int32_t to, const string* habit = nullptr) const {
+        vector<uint32_t> out;
+        if (habit) {
+            uint32_t id = 0;
+            if (!strings.find(*habit, id)) return out;
+            auto it = byHabit.find(id);
+            if (it == byHabit.end()) return out;
+            if (from == INT32_MIN && to == INT32_MAX) return it->second;
+            vector<uint32_t> inRange = query(from, to);
+            sort(inRange.begin(), inRange.end());
+            set_intersection(it->second.begin(), it->second.end(), inRange.begin(), inRange.end(), back_inserter(out));
+            return out;
+        }
+        for (auto it = byDay.lower_bound(from); it != byDay.end() && it->first <= to; ++it)
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        return out;
+    }
+
+    bool readRecord(ifstream& in, uint32_t n, LogRecord& r) const {
+        char buf[LOG_RECORD_SIZE];
+        in.clear();
+        in.seekg(static_cast<streamoff>(uint64_t(n) * LOG_RECORD_SIZE));
+        if (!in.read(buf, LOG_RECORD_SIZE)) return false;
+        r = decodeLogRecord(buf);
+        return true;
+    }
+
+    // The text layout log.txt always used; misses now say "missed".
+    string render(const LogRecord& r) const {
+        string line = "[" + formatTimestamp(static_cast<time_t>(r.when)) + "] ";
+        line += strings.name(r.user);
+        line += r.outcome ? " completed habit: " : " missed habit: ";
+        line += strings.name(r.habit);
+        return line;
+    }
+};
+
+// Batches entries in a fixed ring buffer and appends them to log.bin. The
+// batch is written with one call when the ring fills, when the oldest entry
+// has waited FLUSH_SECONDS (checked on each log() and by the owner through
+// due()), on flush(), and on destruction.
+class ActivityLogger {
+private:
+    static constexpr size_t CAPACITY = 256;
+    static constexpr int FLUSH_SECONDS = 2;
+
+    string textPath;   // legacy log.txt: imported once, target of exportText()
+    BackgroundWriter* writer;   // when set, batches are handed off instead of written
+    vector<LogEntry> ring;
+    size_t head;    // oldest pending entry
+    size_t count;   // pending entries
+    string out;     // reused encoding buffer
+    LogIndex index;
+    bool opened;    // strings loaded, log.bin tail checked
+    bool indexed;   // postings built; kept current from then on
+
+    // Writes strings before records so every id in log.bin resolves.
+    void write(string strs, string records) {
+        if (writer) {
+            if (!strs.empty()) writer->submit({WriteJob::Append, index.stringsFile(), std::move(strs)});
+            writer->submit({WriteJob::Append, index.path(), std::move(records)});
+            return;
+        }
+        if (!strs.empty()) runWriteJob({WriteJob::Append, index.stringsFile(), std::move(strs)});
+        runWriteJob({WriteJob::Append, index.path(), std::move(records)});
+    }
+
+    LogRecord toRecord(const LogEntry& e) {
+        LogRecord r;
+        r.when = static_cast<int64_t>(e.when);
+        r.user = index.names().intern(e.user);
+        r.habit = index.names().intern(e.habit);
+        r.outcome = e.success ? 1 : 0;
+        r.motivation = static_cast<uint8_t>(max(0, min(255, e.motivation)));
+        return r;
+    }
+
+    // First run with the binary format: carry the old text log over.
+    void importText() {
+        ifstream fin(textPath);
+        if (!fin) return;
+        string line, records;
+        LogEntry e;
+        while (getline(fin, line)) {
+            if (!parseLogLine(line, e)) continue;
+            encodeLogRecord(records, toRecord(e));
+        }
+        if (!records.empty()) write(index.names().takePending(), std::move(records));
+    }
+
+    void ensureOpen() {
+        if (opened) return;
+        opened = true;
+        std::error_code ec;
+        bool fresh = !filesystem::exists(index.path(), ec);
+        index.open();
+        if (fresh) importText();
+    }
+
+    // Only the viewer needs postings, so only it pays for the scan.
+    void ensureIndex() {
+        ensureOpen();
+        if (indexed) return;
+        indexed = true;
+        if (writer) writer->waitIdle();   // the scan must see every queued append
+        index.scan();
+    }
+
+    // Encodes the entries into `out`, adding them to the postings once built.
+    template <class Get>
+    void encode(size_t n, Get&& get) {
+        out.clear();
+        for (size_t i = 0; i < n; ++i) {
+            LogRecord r = toRecord(get(i));
+            if (indexed) index.add(r);
+            encodeLogRecord(out, r);
+        }
+    }
+
+public:
+    explicit ActivityLogger(const string& dir = ".")
+        : textPath(dir + "/log.txt"), writer(nullptr), ring(CAPACITY), head(0), count(0),
+          index(dir + "/log.bin", dir + "/log.strings"), opened(false), indexed(false) {}
+
+    // The writer keeps log files open between batches; let go of ours.
+    ~ActivityLogger() {
+        flush();
+        if (writer) {
+            writer->submit({WriteJob::Close, index.stringsFile(), string()});
+            writer->submit({WriteJob::Close, index.path(), string()});
+        }
+    }
+
+    ActivityLogger(const ActivityLogger&) = delete;
+    ActivityLogger& operator=(const ActivityLogger&) = delete;
+
+    const string& getTextPath() const { return textPath; }
+    void attachWriter(BackgroundWriter* w) { writer = w; }
+
+    void log(const string& username, const string& habitName, bool success, int motivation) {
+        time_t now = time(nullptr);
+        if (count == CAPACITY) flush();
+        LogEntry& e = ring[(head + count) % CAPACITY];
+        e.when = now;
+        e.user = username;
+        e.habit = habitName;
+        e.success = success;
+        e.motivation = motivation;
+        ++count;
+        if (count == CAPACITY || due()) flush();
+    }
+
+    bool hasPending() const { return count > 0; }
+
+    // The oldest pending entry has waited FLUSH_SECONDS.
+    bool due() const { return count && time(nullptr) - ring[head].when >= FLUSH_SECONDS; }
+
+    // Writes pending entries and then these in a single append.
+    void logBatch(const vector<LogEntry>& entries) {
+        flush();
+        if (entries.empty()) return;
+        ensureOpen();
+        encode(entries.size(), [&](size_t i) -> const LogEntry& { return entries[i]; });
+        write(index.names().takePending(), out);
+    }
+
+    // Built on first use by the viewer; logging alone never scans log.bin.
+    const LogIndex& getIndex() {
+        ensureIndex();
+        return index;
+    }
+
+    void flush() {
+        if (count == 0) return;
+        ensureOpen();
+        encode(count, [this](size_t i) -> const LogEntry& { return ring[(head + i) % CAPACITY]; });
+        write(index.names().takePending(), out);
+        head = (head + count) % CAPACITY;
+        count = 0;
+    }
+
+    // Render the whole binary log as text into log.txt (temp file + rename).
+    bool exportText() {
+        ensureIndex();
+        ifstream fin(index.path(), ios::binary);
+        string tmp = textPath + ".tmp";
+        ofstream fout(tmp, ios::binary | ios::trunc);
+        if (!fout) return false;
+        LogRecord r;
+        for (uint32_t n = 0; n < index.lineCount(); ++n)
+            if (index.readRecord(fin, n, r)) fout << index.render(r) << '\n';
+        fout.close();
+        std::error_code ec;
+        filesystem::rename(tmp, textPath, ec);
+        return !ec;
+    }
+};
+
+// --------------------- DASHBOARD EXPORTS ----------------------------
+// Tracks which dashboard files are stale and rewrites only those. The
+// first change after a quiet period is exported at once; further changes
+// inside WINDOW are coalesced into one export on the next tick or flush.
+// Owners also tick while idle (the menu while waiting for input, the
+// service on a timer), so the trailing export is not held back.
+class ExportManager {
+private:
+    static constexpr chrono::milliseconds WINDOW{500};
+
+    string dir;
+    bool dirReady;
+    BackgroundWriter* writer;
+    vector<char> dirty;          // by habit id
+    vector<HabitId> dirtyList;
+    bool graphDirty;
+    chrono::steady_clock::time_point lastExport;
+
+    bool ensureDir() {
+        if (dirReady) return true;
+        std::error_code ec;
+        filesystem::create_directories(dir, ec);
+        if (ec) {
+            ++writeFailures;
+            cerr << "Warning: cannot create " << dir << ": " << ec.message() << '\n';
+            return false;
+        }
+        dirReady = true;
+        return true;
+    }
+
+    void writeHabit(const Habit& h) {
+        if (!writer) {
+            h.exportProgressJson(dir);
+            return;
+        }
+        ostringstream out;
+        h.getTree().writeJson(out);
+        writer->submit({WriteJob::Replace, h.progressJsonPath(dir), out.str()});
+    }
+
+    void writeGraph(const HabitGraph& graph) {
+        string path = graphFile();
+        if (!writer) {
+            graph.exportToJsonFile(path);
+            return;
+        }
+        ostringstream out;
+        graph.writeJson(out);
+        writer->submit({WriteJob::Replace, path, out.str()});
+    }
+
+public:
+    explicit ExportManager(const string& folder = "dashboard_data")
+        : dir(folder), dirReady(false), writer(nullptr), graphDirty(false) {}
+
+    void attachWriter(BackgroundWriter* w) { writer = w; }
+
+    string graphFile() const { return dir + "/habit_graph.json"; }
+
+    void habitChanged(HabitId id) {
+        if (id >= dirty.size()) dirty.resize(id + 1, 0);
+        if (!dirty[id]) dirtyList.push_back(id);
+        dirty[id] = 1;
+    }
+    void graphChanged() { graphDirty = true; }
+    bool pending() const { return graphDirty || !dirtyList.empty(); }
+
+    // Resolves an id to the live habit, or nullptr if it was deleted.
+    using Lookup = function<const Habit*(HabitId)>;
+
+    static constexpr int WINDOW_MS = static_cast<int>(WINDOW.count());
+
+    // Something is dirty and the window since the last export has passed.
+    bool due() const { return pending() && chrono::steady_clock::now() - lastExport >= WINDOW; }
+
+    // Export now unless another export happened within the window.
+    void tick(const Lookup& lookup, const HabitGraph& graph) {
+        if (due()) flush(lookup, graph);
+    }
+
+    void flush(const Lookup& lookup, const HabitGraph& graph) {
+        if (!pending() || !ensureDir()) return;
+        for (HabitId id : dirtyList) {
+            dirty[id] = 0;
+            if (const Habit* h = lookup(id)) writeHabit(*h);
+        }
+        dirtyList.clear();
+        if (graphDirty) writeGraph(graph);
+        graphDirty = false;
+        lastExport = chrono::steady_clock::now();
+    }
+};
+
+// --------------------- HABIT TRACKER --------------------------------
+class HabitTracker : public User {
+private:
+    vector<Habit> habits;
+    HabitIndex& ids;            // shared with the graph and exporters
+    vector<int32_t> slotOf;     // habit id -> position in habits, -1 if none
+    string dataFile;
+    string snapshotFile;
+    HabitJournal journal;
+    ActivityLogger logger;
+    ExportManager exports;
+    BackgroundWriter* writer;   // optional, owned by main
+
+    static constexpr size_t COMPACT_EVERY = 4096;   // journal records per snapshot
+    static constexpr size_t LOCK_STRIPES = 16;
+
+    // Locking for the non-interactive operations. `structure` is held
+    // exclusively by anything that adds, removes or rewrites habits as a
+    // whole (add, delete, ingest, newDay, load, save, exports) and shared by
+    // everything else. A mark also holds its habit's stripe (id %
+    // LOCK_STRIPES), so marks on different habits run in parallel. Journal,
+    // log and export bookkeeping happens either under the exclusive lock or
+    // under the shared lock plus `sinks`. The menu methods run on the main
+    // thread and take no locks.
+    mutable shared_mutex structure;
+    mutable array<mutex, LOCK_STRIPES> stripes;
+    mutable mutex sinks;
+
+    // Every habit enters the list here, so it always carries its id.
+    Habit& appendHabit(const string& name, int streak, bool good) {
+        habits.emplace_back(name, streak, good);
+        Habit& h = habits.back();
+        HabitId id = ids.intern(name);
+        h.setId(id);
+        if (id >= slotOf.size()) slotOf.resize(id + 1, -1);
+        if (slotOf[id] < 0) slotOf[id] = static_cast<int32_t>(habits.size() - 1);
+        return h;
+    }
+
+    void removeAt(size_t idx) {
+        HabitId gone = habits[idx].getId();
+        if (slotOf[gone] == static_cast<int32_t>(idx)) slotOf[gone] = -1;
+        habits.erase(habits.begin() + idx);
+        // shift later positions; a duplicate name may take over the freed id
+        for (size_t p = idx; p < habits.size(); ++p) {
+            int32_t& slot = slotOf[habits[p].getId()];
+            if (slot == static_cast<int32_t>(p + 1) || slot < 0) slot = static_cast<int32_t>(p);
+        }
+    }
+
+    // Remove a deleted habit's influence edges, unless a duplicate of the
+    // name is still tracked.
+    void dropFromGraph(const string& name, HabitGraph& graph) {
+        if (findHabit(name) >= 0) return;
+        graph.removeHabit(name);
+        exports.graphChanged();
+    }
+
+    ExportManager::Lookup habitLookup() const {
+        return [this](HabitId id) { return habitById(id); };
+    }
+
+    void record(JournalOp op, size_t index, const Habit& h, bool success = false, int motivation = 0,
+                time_t when = 0) {
+        JournalRecord r;
+        r.op = op;
+        r.timestamp = static_cast<int64_t>(when ? when : time(nullptr));
+        r.habitIndex = static_cast<uint32_t>(index);
+        r.day = static_cast<uint32_t>(h.getTree().getCurrentDay());
+        r.success = success;
+        r.motivation = static_cast<uint8_t>(max(0, min(255, motivation)));
+        r.name = h.getName();
+        journal.append(r);
+    }
+
+    // Everything a recorded mark fans out to: journal, graph, log, exports.
+    void afterMark(size_t idx, bool success, int motivation, HabitGraph& graph) {
+        const Habit& h = habits[idx];
+        graph.updateInfluence(h.getId(), success, h.isGoodHabit(), motivation);
+        lock_guard<mutex> hold(sinks);
+        record(JournalOp::Mark, idx, h, success, motivation);
+        logger.log(username, h.getName(), success, motivation);
+        exports.habitChanged(h.getId());
+        exports.graphChanged();
+    }
+
+    // commitJournal for callers already holding `structure` exclusively.
+    void commitHeld() {
+        journal.commit();
+        if (journal.size() >= COMPACT_EVERY) compactHeld();
+    }
+
+    void compactHeld() {
+        journal.commit();
+        uint32_t next = journal.getGeneration() + 1;
+        if (writeSnapshot(next)) {
+            journal.reset(next);
+        } else {
+            ++writeFailures;
+            cerr << "Warning: cannot write snapshot " << snapshotFile << '\n';
+        }
+    }
+
+    // Journal records carry the position the habit had when they were
+    // written; replay reproduces those positions, so the name check only
+    // fails if the snapshot and journal disagree.
+    int findForReplay(const JournalRecord& r) const {
+        if (r.habitIndex < habits.size() && habits[r.habitIndex].getName() == r.name)
+            return static_cast<int>(r.habitIndex);
+        return findHabit(r.name);
+    }
+
+    void applyRecord(const JournalRecord& r) {
+        if (r.op == JournalOp::Add) {
+            appendHabit(r.name, 0, r.success);
+            return;
+        }
+        int idx = findForReplay(r);
+        if (idx < 0) return;
+        if (r.op == JournalOp::Mark) habits[idx].replayMark(r.day, r.success, r.motivation);
+        else if (r.op == JournalOp::Delete) removeAt(idx);
+    }
+
+    // One buffer: header, fixed-size habit records, day columns, string
+    // table. Written to a temp file, synced and renamed over the old one.
+    bool writeSnapshot(uint32_t journalGeneration) const {
+        SnapshotHeader hdr = {};
+        memcpy(hdr.magic, "HSNP", 4);
+        hdr.version = SNAPSHOT_VERSION;
+        hdr.journalGeneration = journalGeneration;
+        hdr.habitCount = static_cast<uint32_t>(habits.size());
+        uint64_t totalDays = 0, nameBytes = 0;
+        for (const auto& h : habits) {
+            totalDays += h.getTree().size();
+            nameBytes += h.getName().size();
+        }
+        hdr.dayCount = totalDays;
+        hdr.recordsOffset = sizeof(SnapshotHeader);
+        hdr.daysOffset = hdr.recordsOffset + habits.size() * sizeof(SnapshotHabit);
+        hdr.successOffset = hdr.daysOffset + totalDays * sizeof(uint32_t);
+        hdr.motivationOffset = hdr.successOffset + totalDays;
+        hdr.stringsOffset = hdr.motivationOffset + totalDays;
+        hdr.stringsSize = nameBytes;
+
+        string buf(hdr.stringsOffset + nameBytes, '\0');
+        memcpy(&buf[0], &hdr, sizeof(hdr));
+        uint64_t day = 0, str = 0;
+        for (size_t i = 0; i < habits.size(); ++i) {
+            const Habit& h = habits[i];
+            SnapshotHabit rec = {};
+            rec.nameOffset = static_cast<uint32_t>(str);
+            rec.nameLength = static_cast<uint32_t>(h.getName().size());
+            rec.streak = h.getStreak();
+            rec.flags = h.isGoodHabit() ? SnapshotHabit::GOOD : 0;
+            rec.firstDay = day;
+            rec.dayCount = static_cast<uint32_t>(h.getTree().size());
+            memcpy(&buf[hdr.recordsOffset + i * sizeof(SnapshotHabit)], &rec, sizeof(rec));
+            memcpy(&buf[hdr.stringsOffset + str], h.getName().data(), rec.nameLength);
+            str += rec.nameLength;
+            h.getTree().forEachDay([&](uint32_t d, bool success, int motivation) {
+                memcpy(&buf[hdr.daysOffset + day * sizeof(uint32_t)], &d, sizeof(d));
+                buf[hdr.successOffset + day] = success ? 1 : 0;
+                buf[hdr.motivationOffset + day] = static_cast<char>(motivation);
+                ++day;
+            });
+        }
+
+        string tmp = snapshotFile + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+        syncFile(f);
+        fclose(f);
+        if (!ok) return false;
+#ifdef _WIN32
+        std::remove(snapshotFile.c_str());
+#endif
+        return std::rename(tmp.c_str(), snapshotFile.c_str()) == 0;
+    }
+
+    // Maps the snapshot and builds habits straight from the mapped records.
+    bool readSnapshot(uint32_t& journalGeneration) {
+        MappedFile file(snapshotFile);
+        if (!file.data()) return false;
+        SnapshotView view(file.data(), file.size());
+        if (!view.valid()) {
+            cerr << "Warning: ignoring unreadable snapshot " << snapshotFile << '\n';
+            return false;
+        }
+        journalGeneration = view.journalGeneration();
+        habits.reserve(habits.size() + view.habitCount());
+        for (uint32_t i = 0; i < view.habitCount(); ++i) {
+            const SnapshotHabit& rec = view.habit(i);
+            Habit& h = appendHabit(string(view.name(rec), rec.nameLength), rec.streak,
+                                   (rec.flags & SnapshotHabit::GOOD) != 0);
+            const uint32_t* days = view.days(rec);
+            const uint8_t* success = view.success(rec);
+            const uint8_t* motivation = view.motivation(rec);
+            for (uint32_t d = 0; d < rec.dayCount; ++d)
+                h.restoreDay(days[d], success[d] != 0, motivation[d]);
+        }
+        return true;
+    }
+
+    void loadText() {
+        ifstream fin(dataFile);
+        if (!fin.is_open()) return;
+
+        string line;
+        while (getline(fin, line)) {
+            stringstream ss(line);
+
+            int streak = 0;
+            char typeChar;
+
+            // Read streak and type (G or B)
+            if (!(ss >> streak >> typeChar)) continue;
+
+            // Skip tab or space before the name
+            if (ss.peek() == '\t' || ss.peek() == ' ') ss.get();
+
+            // Read full habit name (can include spaces)
+            string name;
+            getline(ss, name);
+
+            // Determine if it's a good or bad habit
+            bool isGood = (typeChar == 'G' || typeChar == 'g');
+
+            // Add to the list
+            appendHabit(name, streak, isGood);
+        }
+        fin.close();
+    }
+
+public:
+    // All files live in `dir`, which must exist; "." is the working directory.
+    HabitTracker(const string& name, HabitIndex& index, const string& dir = ".")
+        : User(name), ids(index), dataFile(dataPath(dir, "habits.txt")), snapshotFile(dataPath(dir, "habits.snap")),
+          journal(dataPath(dir, "habits.journal")), logger(dir), exports(dataPath(dir, "dashboard_data")), writer(nullptr) {}
+
+    // Route log batches and dashboard exports through a background thread.
+    void attachWriter(BackgroundWriter* w) {
+        writer = w;
+        logger.attachWriter(w);
+        exports.attachWriter(w);
+    }
+
+    // Called once per menu loop (and per service request): writes log
+    // entries and dashboard files whose window has passed. Cheap when
+    // nothing is due.
+    void tickExports(const HabitGraph& graph) {
+        {
+            shared_lock<shared_mutex> shared(structure);
+            lock_guard<mutex> hold(sinks);
+            if (logger.due()) logger.flush();
+            if (!exports.due()) return;
+        }
+        unique_lock<shared_mutex> hold(structure);
+        exports.tick(habitLookup(), graph);
+    }
+
+    void flushExports(const HabitGraph& graph) {
+        unique_lock<shared_mutex> hold(structure);
+        exports.flush(habitLookup(), graph);
+    }
+
+    void flushLog() {
+        shared_lock<shared_mutex> shared(structure);
+        lock_guard<mutex> hold(sinks);
+        logger.flush();
+    }
+
+    // Log entries or dashboard files are waiting for tickExports.
+    bool hasPendingOutput() const {
+        shared_lock<shared_mutex> shared(structure);
+        lock_guard<mutex> hold(sinks);
+        return logger.hasPending() || exports.pending();
+    }
+
+    // End of a user action: make its records durable, compact if due.
+    void commitJournal() {
+        {
+            shared_lock<shared_mutex> shared(structure);
+            lock_guard<mutex> hold(sinks);
+            journal.commit();
+            if (journal.size() < COMPACT_EVERY) return;
+        }
+        unique_lock<shared_mutex> hold(structure);
+        if (journal.size() >= COMPACT_EVERY) compactHeld();
+    }
+
+    bool hasHabit(const string& name) const {
+        shared_lock<shared_mutex> hold(structure);
+        return findHabit(name) >= 0;
+    }
+
+    // Runs fn on a consistent view of every habit: marks wait until it
+    // returns. Reports use this while other threads keep marking.
+    void readHabits(const function<void(const vector<Habit>&)>& fn) const {
+        shared_lock<shared_mutex> hold(structure);
+        vector<unique_lock<mutex>> all;
+        all.reserve(LOCK_STRIPES);
+        for (auto& stripe : stripes) all.emplace_back(stripe);
+        fn(habits);
+    }
+
+    // Position of the first habit with this name, or -1. O(1) via the id index.
+    int findHabit(const string& name) const {
+        HabitId id = ids.find(name);
+        return (id != NO_HABIT && id < slotOf.size()) ? slotOf[id] : -1;
+    }
+
+    const Habit* habitById(HabitId id) const {
+        return (id < slotOf.size() && slotOf[id] >= 0) ? &habits[slotOf[id]] : nullptr;
+    }
+
+    // Non-interactive operations (batch mode). They print nothing and leave
+    // fsync to the journal's group commit and the final save.
+    bool addHabit(const string& name, bool good = true) {
+        unique_lock<shared_mutex> hold(structure);
+        if (name.empty() || findHabit(name) >= 0) return false;
+        appendHabit(name, 0, good);
+        record(JournalOp::Add, habits.size() - 1, habits.back(), good);
+        return true;
+    }
+
+    bool deleteHabit(const string& name, HabitGraph& graph) {
+        unique_lock<shared_mutex> hold(structure);
+        int idx = findHabit(name);
+        if (idx < 0) return false;
+        record(JournalOp::Delete, idx, habits[idx]);
+        removeAt(idx);
+        dropFromGraph(name, graph);
+        return true;
+    }
+
+    // Adds or merges an influence. The graph is persisted through its
+    // dashboard export (habit_graph.json), so that is marked stale too.
+    void addInfluence(const string& from, const string& to, int weight, HabitGraph& graph) {
+        shared_lock<shared_mutex> shared(structure);
+        graph.addInfluence(from, to, weight);
+        lock_guard<mutex> hold(sinks);
+        exports.graphChanged();
+    }
+
+    bool markHabit(const string& name, bool success, int motivation, HabitGraph& graph) {
+        shared_lock<shared_mutex> shared(structure);
+        int idx = findHabit(name);
+        if (idx < 0) return false;
+        lock_guard<mutex> hold(stripes[habits[idx].getId() % LOCK_STRIPES]);
+        if (!habits[idx].mark(success, motivation)) return false;
+        afterMark(idx, success, motivation, graph);
+        return true;
+    }
+
+    // Bulk ingestion for backfills. Events are grouped by habit with a
+    // counting sort; each habit's days and influence weights are updated in
+    // one pass, then the journal, log and dashboard are written once. Every
+    // event records a new day (no once-per-day guard); events naming
+    // unknown habits are skipped. Returns the number applied.
+    size_t ingest(const vector<MarkEvent>& events, HabitGraph& graph) {
+        unique_lock<shared_mutex> hold(structure);
+        vector<int32_t> target(events.size(), -1);
+        vector<uint32_t> start(habits.size() + 1, 0);
+        for (size_t e = 0; e < events.size(); ++e) {
+            int idx = findHabit(events[e].habit);
+            if (idx < 0) continue;
+            target[e] = idx;
+            ++start[idx + 1];
+        }
+        for (size_t i = 0; i < habits.size(); ++i) start[i + 1] += start[i];
+        vector<uint32_t> order(start.back());
+        vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (size_t e = 0; e < events.size(); ++e)
+            if (target[e] >= 0) order[fill[target[e]]++] = static_cast<uint32_t>(e);
+
+        vector<int> steps;
+        journal.holdCommits(true);
+        for (size_t i = 0; i < habits.size(); ++i) {
+            if (start[i] == start[i + 1]) continue;
+            Habit& h = habits[i];
+            steps.clear();
+            for (uint32_t k = start[i]; k < start[i + 1]; ++k) {
+                const MarkEvent& ev = events[order[k]];
+                h.backfill(ev.success, ev.motivation);
+                record(JournalOp::Mark, i, h, ev.success, ev.motivation, ev.when);
+                steps.push_back(HabitGraph::influenceStep(ev.success, h.isGoodHabit(), ev.motivation));
+            }
+            graph.applyInfluenceSteps(h.getId(), steps);
+            exports.habitChanged(h.getId());
+        }
+        journal.holdCommits(false);
+
+        // the activity log keeps the events' original order
+        vector<LogEntry> entries;
+        entries.reserve(order.size());
+        for (size_t e = 0; e < events.size(); ++e) {
+            if (target[e] < 0) continue;
+            LogEntry le;
+            le.when = events[e].when ? events[e].when : time(nullptr);
+            le.user = username;
+            le.habit = events[e].habit;
+            le.success = events[e].success;
+            le.motivation = events[e].motivation;
+            entries.push_back(std::move(le));
+        }
+        logger.logBatch(entries);
+
+        if (!order.empty()) exports.graphChanged();
+        commitHeld();
+        exports.flush(habitLookup(), graph);
+        return order.size();
+    }
+
+    // Starts a new tracking day: every habit can be marked again.
+    void newDay() {
+        unique_lock<shared_mutex> hold(structure);
+        for (auto& h : habits) h.resetDay();
+    }
+
+
+    // Interactive add habit (uses getline)
+   void addHabitInteractive() {
+            cout << "Enter habit name: ";
+            string name;
+            getline(cin, name);
+            if (name.empty()) {
+                cout << "Habit name cannot be empty.\n";
+                return;
+            }
+            if (findHabit(name) >= 0) {
+                cout << "Habit \"" << name << "\" already exists.\n";
+                return;
+            }
+
+            cout << "Is this a Good habit or a Bad habit? (G/B): ";
             char type;
             cin >> type;
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
             bool isGood = (type == 'G' || type == 'g');
 
-            habits.emplace_back(name, 0, isGood);
+            addHabit(name, isGood);
+            commitJournal();
             cout << (isGood ? "✅ Good habit added: " : "⚠️ Bad habit added: ") << name << '\n';
         }
 
 
-    void deleteHabit() {
+    void deleteHabit(HabitGraph& graph) {
         if (habits.empty()) {
             cout << "No habits to delete.\n";
             return;
@@ -352,174 +2665,581 @@ public:
             cout << "Invalid choice.\n";
             return;
         }
-
-        cout << "Habit \"" << habits[choice - 1].getName() << "\" deleted.\n";
-        habits.erase(habits.begin() + (choice - 1));
+
+        string gone = habits[choice - 1].getName();
+        cout << "Habit \"" << gone << "\" deleted.\n";
+        record(JournalOp::Delete, choice - 1, habits[choice - 1]);
+        removeAt(choice - 1);
+        dropFromGraph(gone, graph);
+        commitJournal();
+    }
+
+    void markHabit(HabitGraph& graph) {
+        if (habits.empty()) {
+            cout << "No habits added yet.\n";
+            return;
+        }
+        cout << "Select habit number:\n";
+        for (size_t i = 0; i < habits.size(); ++i)
+            cout << i + 1 << ". " << habits[i].getName() << '\n';
+
+        int choice = 0;
+        if (!(cin >> choice)) {
+            cout << "Invalid input.\n";
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        if (choice < 1 || choice > static_cast<int>(habits.size())) {
+            cout << "Invalid habit number!\n";
+            return;
+        }
+
+        Habit& h = habits[choice - 1];
+        cout << "Mark status for \"" << h.getName() << "\":\n1. Done\n2. Missed\nChoice: ";
+        int status;
+        if (!(cin >> status)) {
+            cout << "Invalid input.\n";
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            return;
+        }
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        cout << "Enter your motivation level (1–10): ";
+        int motivation;
+        if (!(cin >> motivation)) {
+            cout << "Invalid motivation input. Using default 5.\n";
+            motivation = 5;
+        }
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+        bool marked = (status == 1) ? h.markComplete(motivation) : h.markMissed(motivation);
+        if (!marked) return;
+        afterMark(choice - 1, status == 1, motivation, graph);
+        commitJournal();
+        exports.tick(habitLookup(), graph);
+    }
+
+
+    void showAll() const {
+        cout << "\n--- Your Habits ---\n";
+        if (habits.empty()) {
+            cout << "(none)\n";
+        } else {
+            for (const auto& h : habits)
+                h.display();
+        }
+        cout << "-------------------\n";
+    }
+
+    const vector<Habit>& getHabits() const { return habits; }
+
+    void viewLogs() {
+        logger.flush();
+        waitForWrites();
+        ::viewLogs(logger);
+    }
+
+    // Returns once everything handed to the background writer is on disk.
+    void waitForWrites() {
+        if (writer) writer->waitIdle();
+    }
+
+    // Save & Load
+    // habits.txt stays the human-readable export; the snapshot and journal
+    // carry the full day history.
+    void saveData() {
+        unique_lock<shared_mutex> hold(structure);
+        saveHabitsToFile(habits, dataFile);
+        compactHeld();
+    }
+
+    // Fold the journal into a fresh snapshot, then truncate it.
+    void compact() {
+        unique_lock<shared_mutex> hold(structure);
+        compactHeld();
+    }
+
+    // Snapshot (or habits.txt when there is none yet) plus the journal tail.
+    void loadData() {
+        unique_lock<shared_mutex> hold(structure);
+        uint32_t covered = 0;
+        if (!readSnapshot(covered)) loadText();
+        journal.replay(covered, [this](const JournalRecord& r) { applyRecord(r); });
+    }
+
+    // The graph is only persisted as its dashboard export; read it back
+    // so the next export does not replace it with an empty one.
+    bool loadGraph(HabitGraph& graph) { return graph.loadJsonFile(exports.graphFile()); }
+
+
+    // Polymorphism
+    void displayInfo() override {
+        cout << "Habit Tracker for user: " << username << '\n';
+    }
+};
+
+// --------------------- TENANT STORE ---------------------------------
+// Many users' trackers in one process. Each tenant keeps its files in its
+// own directory, root/<user>, and is loaded on first use. Tenants are
+// spread over SHARDS shards by name hash. Requests for loaded tenants share
+// their shard's lock (the tracker and graph lock internally, so one
+// tenant's requests can run in parallel); loading takes it exclusively and,
+// once the shard holds more than its share of the capacity, saves and
+// unloads the tenant with the oldest use stamp. That tenant is found by
+// scanning the shard, which only happens when a load overflows it; in
+// exchange a hit just stores an atomic stamp under the shared lock, where
+// an LRU list would need exclusive access on every request.
+class TenantStore {
+public:
+    struct Tenant {
+        string user;
+        string dir;
+        HabitIndex ids;   // declared first: tracker and graph hold references
+        HabitTracker tracker;
+        HabitGraph graph;
+        atomic<uint64_t> lastUse{0};
+
+        Tenant(const string& name, const string& folder)
+            : user(name), dir(folder), tracker(name, ids, folder), graph(ids) {}
+    };
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct Shard {
+        shared_mutex lock;
+        unordered_map<string, unique_ptr<Tenant>> tenants;
+    };
+
+    string root;
+    size_t perShard;
+    BackgroundWriter* writer;
+    array<Shard, SHARDS> shards;
+    atomic<uint64_t> clock{0};   // use stamps; the oldest in a full shard is evicted
+
+    // Letters, digits, '_', '-' and '.', not starting with '.', so the name
+    // is always a single safe directory component.
+    static bool validName(const string& user) {
+        if (user.empty() || user.size() > 64 || user[0] == '.') return false;
+        for (char c : user)
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.') return false;
+        return true;
+    }
+
+    Shard& shardFor(const string& user) { return shards[hash<string>()(user) % SHARDS]; }
+
+    static void save(Tenant& t) {
+        t.tracker.saveData();
+        t.tracker.flushExports(t.graph);
+        t.tracker.flushLog();
+    }
+
+    // Caller holds shard.lock exclusively.
+    Tenant* load(Shard& shard, const string& user) {
+        auto it = shard.tenants.find(user);
+        if (it != shard.tenants.end()) return it->second.get();   // loaded while we waited
+        string dir = root + "/" + user;
+        std::error_code ec;
+        filesystem::create_directories(dir, ec);
+        if (ec) {
+            cerr << "Cannot create tenant directory " << dir << ": " << ec.message() << '\n';
+            return nullptr;
+        }
+        auto tenant = make_unique<Tenant>(user, dir);
+        tenant->tracker.attachWriter(writer);
+        tenant->tracker.loadData();
+        tenant->tracker.loadGraph(tenant->graph);
+
+        while (shard.tenants.size() >= perShard) {
+            auto victim = min_element(shard.tenants.begin(), shard.tenants.end(), [](const auto& a, const auto& b) {
+                return a.second->lastUse < b.second->lastUse;
+            });
+            save(*victim->second);
+            shard.tenants.erase(victim);
+            // With --async-io the save is only queued; a quick reload would
+            // read the log and graph files before the writes land.
+            if (writer) writer->waitIdle();
+        }
+        Tenant* t = tenant.get();
+        shard.tenants.emplace(user, std::move(tenant));
+        return t;
+    }
+
+public:
+    // Keeps at most about `capacity` tenants loaded (at least one per shard).
+    TenantStore(const string& rootDir, size_t capacity, BackgroundWriter* w = nullptr)
+        : root(rootDir), perShard(max<size_t>(1, capacity / SHARDS)), writer(w) {}
+
+    ~TenantStore() { unloadAll(); }
+
+    TenantStore(const TenantStore&) = delete;
+    TenantStore& operator=(const TenantStore&) = delete;
+
+    // Runs fn on the user's tenant, loading it first if needed. The tenant
+    // cannot be evicted while fn runs. False if the name is not a valid
+    // tenant or its directory cannot be created.
+    bool with(const string& user, const function<void(Tenant&)>& fn) {
+        if (!validName(user)) return false;
+        Shard& shard = shardFor(user);
+        {
+            shared_lock<shared_mutex> guard(shard.lock);
+            auto it = shard.tenants.find(user);
+            if (it != shard.tenants.end()) {
+                it->second->lastUse = ++clock;
+                fn(*it->second);
+                return true;
+            }
+        }
+        unique_lock<shared_mutex> guard(shard.lock);
+        Tenant* t = load(shard, user);
+        if (!t) return false;
+        t->lastUse = ++clock;
+        fn(*t);
+        return true;
+    }
+
+    // Runs fn on every loaded tenant, one shard at a time.
+    void forEachLoaded(const function<void(Tenant&)>& fn) {
+        for (auto& shard : shards) {
+            shared_lock<shared_mutex> guard(shard.lock);
+            for (auto& entry : shard.tenants) fn(*entry.second);
+        }
+    }
+
+    // Saves and unloads every tenant, and waits for their queued writes.
+    void unloadAll() {
+        for (auto& shard : shards) {
+            unique_lock<shared_mutex> guard(shard.lock);
+            for (auto& entry : shard.tenants) save(*entry.second);
+            shard.tenants.clear();
+        }
+        if (writer) writer->waitIdle();
+    }
+};
+
+// --------------------- REPORT GENERATOR -----------------------------
+class ReportBase {
+public:
+    virtual ~ReportBase() = default;
+    virtual void generateReport(HabitGraph& graph, ostream& out = cout) = 0;
+};
+
+// Formats into one buffer and writes it once. With many habits the
+// per-habit sections are built in parallel, one slot per chunk, and joined
+// in order, so the output is the same either way.
+class ReportGenerator : public ReportBase, public User {
+private:
+    static constexpr size_t PARALLEL_HABITS = 512;   // below this one thread is faster
+    static constexpr size_t GRAIN = 128;             // habits per parallel chunk
+
+    const vector<Habit>& habits;
+
+    static void appendFixed(string& buf, double v) {
+        char tmp[32];
+        int len = snprintf(tmp, sizeof(tmp), "%.1f", v);
+        buf.append(tmp, len > 0 ? min<size_t>(len, sizeof(tmp) - 1) : 0);
+    }
+
+    static void appendWeight(string& buf, int w) {
+        if (w >= 0) buf += '+';
+        buf += to_string(w);
+    }
+
+    // Appends the sections for habits [begin, end) to buf.
+    void formatHabits(size_t begin, size_t end, const IncomingView& in, string& buf) const {
+        buf.reserve(buf.size() + (end - begin) * 256);
+        for (size_t i = begin; i < end; ++i) {
+            const Habit& h = habits[i];
+            double formation = 0.0, avgMotivation = 0.0;
+            int success = 0, fail = 0;
+            h.getProgress(formation, avgMotivation, success, fail);
+
+            buf += "Habit: ";
+            buf += h.getName();
+            buf += h.isGoodHabit() ? "\nType: Good\n" : "\nType: Bad\n";
+            buf += "Streak: ";
+            buf += to_string(h.getStreak());
+            buf += " days\nSuccesses: ";
+            buf += to_string(success);
+            buf += " | Failures: ";
+            buf += to_string(fail);
+            buf += "\nAverage Motivation: ";
+            appendFixed(buf, avgMotivation);
+            buf += "\nFormation Progress: ";
+            appendFixed(buf, formation);
+            buf += "%\n";
+            HabitId id = h.getId();
+            if (id < in.nodes && in.offsets[id] < in.offsets[id + 1]) {
+                buf += "Influenced By:";
+                for (uint32_t k = in.offsets[id]; k < in.offsets[id + 1]; ++k) {
+                    buf += k == in.offsets[id] ? " " : ", ";
+                    buf += in.names.name(in.sources[k]);
+                    buf += " (";
+                    appendWeight(buf, in.weights[in.slots[k]]);
+                    buf += ")";
+                }
+                buf += "\n";
+            }
+            buf += "----------------------------------------------\n";
+        }
     }
 
-    void markHabit(HabitGraph& graph) {
+public:
+    ReportGenerator(const string& uname, const vector<Habit>& h)
+        : User(uname), habits(h) {}
+
+    void generateReport(HabitGraph& graph, ostream& out = cout) override {
+        string buf = "\n==============================================\n"
+                     "             HABIT ANALYSIS REPORT\n"
+                     "==============================================\n"
+                     "User: " + username + "\n"
+                     "----------------------------------------------\n";
+
         if (habits.empty()) {
-            cout << "No habits added yet.\n";
+            buf += "No habits to analyze yet.\n";
+            out.write(buf.data(), buf.size());
             return;
         }
-        cout << "Select habit number:\n";
-        for (size_t i = 0; i < habits.size(); ++i)
-            cout << i + 1 << ". " << habits[i].getName() << '\n';
 
-        int choice = 0;
-        if (!(cin >> choice)) {
-            cout << "Invalid input.\n";
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
+        size_t n = habits.size();
+        vector<string> sections((n + GRAIN - 1) / GRAIN);
+        graph.withIncoming([&](const IncomingView& in) {
+            auto body = [&](size_t begin, size_t end) { formatHabits(begin, end, in, sections[begin / GRAIN]); };
+            if (n >= PARALLEL_HABITS) workerPool().parallelFor(n, GRAIN, body);
+            else body(0, n);
+        });
+        for (const string& part : sections) buf += part;
+
+        ostringstream tail;
+        graph.showInfluences(tail);
+        tail << "Most Influential Habit: " << graph.getMostInfluential() << "\n";
+        auto leaders = graph.topInfluential(3);
+        if (leaders.size() > 1) {
+            tail << "Influence Leaderboard:\n";
+            for (size_t i = 0; i < leaders.size(); ++i)
+                tail << "  " << i + 1 << ". " << leaders[i].first << " (" << (leaders[i].second >= 0 ? "+" : "") << leaders[i].second << ")\n";
         }
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        if (choice < 1 || choice > static_cast<int>(habits.size())) {
-            cout << "Invalid habit number!\n";
-            return;
+        auto reach = graph.topPropagated(3);
+        if (reach.size() > 1) {
+            tail << "Multi-hop Influence:\n";
+            for (size_t i = 0; i < reach.size(); ++i)
+                tail << "  " << i + 1 << ". " << reach[i].first << " (" << showpos << fixed << setprecision(2) << reach[i].second << noshowpos << ")\n";
         }
+        tail << "==============================================\n";
+        buf += tail.str();
+        out.write(buf.data(), buf.size());
+    }
+};
 
-        Habit& h = habits[choice - 1];
-        cout << "Mark status for \"" << h.getName() << "\":\n1. Done\n2. Missed\nChoice: ";
-        int status;
-        if (!(cin >> status)) {
-            cout << "Invalid input.\n";
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            return;
-        }
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+// Buffered writer for the machine-readable reports. Numbers are formatted
+// and strings escaped straight into a fixed buffer that is flushed to the
+// stream when full, so writing a record does not allocate.
+class RecordWriter {
+private:
+    static constexpr size_t CAPACITY = 1 << 14;
 
-        cout << "Enter your motivation level (1–10): ";
-        int motivation;
-        if (!(cin >> motivation)) {
-            cout << "Invalid motivation input. Using default 5.\n";
-            motivation = 5;
-        }
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    ostream& out;
+    char buf[CAPACITY];
+    size_t used = 0;
 
-        if (status == 1) h.markComplete(motivation);
-        else h.markMissed(motivation);
+public:
+    explicit RecordWriter(ostream& o) : out(o) {}
+    ~RecordWriter() { flush(); }
 
-        graph.updateInfluence(h.getName(), (status == 1), h.isGoodHabit(), motivation);
-                logActivity(username, h.getName());
-                #ifdef _WIN32
-            std::system("if not exist dashboard_data mkdir dashboard_data");
-        #else
-            std::system("mkdir -p dashboard_data");
-        #endif
+    RecordWriter(const RecordWriter&) = delete;
+    RecordWriter& operator=(const RecordWriter&) = delete;
 
-         h.exportProgressJson("dashboard_data");
-         graph.exportToJsonFile("dashboard_data/habit_graph.json");
+    void flush() {
+        if (used) out.write(buf, used);
+        used = 0;
     }
 
+    RecordWriter& raw(char c) {
+        if (used == CAPACITY) flush();
+        buf[used++] = c;
+        return *this;
+    }
 
-    void showAll() const {
-        cout << "\n--- Your Habits ---\n";
-        if (habits.empty()) {
-            cout << "(none)\n";
-        } else {
-            for (const auto& h : habits)
-                h.display();
+    RecordWriter& raw(const char* s, size_t n) {
+        if (n > CAPACITY - used) {
+            flush();
+            if (n > CAPACITY) {
+                out.write(s, n);
+                return *this;
+            }
         }
-        cout << "-------------------\n";
+        memcpy(buf + used, s, n);
+        used += n;
+        return *this;
     }
 
-    const vector<Habit>& getHabits() const { return habits; }
+    RecordWriter& raw(const char* s) { return raw(s, strlen(s)); }
 
-    // Save & Load
-    void saveData(const string& filename = "habits.txt") {
-        saveHabitsToFile(habits, filename);
+    RecordWriter& integer(long long v) {
+        char tmp[24];
+        return raw(tmp, snprintf(tmp, sizeof(tmp), "%lld", v));
     }
 
-   void loadData() {
-    ifstream fin("habits.txt");
-    if (!fin.is_open()) return;
-
-    string line;
-    while (getline(fin, line)) {
-        stringstream ss(line);
+    RecordWriter& decimal(double v) {
+        char tmp[32];
+        return raw(tmp, snprintf(tmp, sizeof(tmp), "%.6g", isfinite(v) ? v : 0.0));
+    }
 
-        int streak = 0;
-        char typeChar;
+    // Quoted JSON string; bytes >= 0x80 pass through as UTF-8.
+    RecordWriter& jsonString(const string& s) {
+        static const char hex[] = "0123456789abcdef";
+        raw('"');
+        for (unsigned char c : s) {
+            if (c == '"' || c == '\\') raw('\\').raw(char(c));
+            else if (c == '\n') raw("\\n", 2);
+            else if (c == '\t') raw("\\t", 2);
+            else if (c < 0x20) raw("\\u00", 4).raw(hex[c >> 4]).raw(hex[c & 15]);
+            else raw(char(c));
+        }
+        return raw('"');
+    }
 
-        // Read streak and type (G or B)
-        if (!(ss >> streak >> typeChar)) continue;
+    // CSV text with quotes doubled, for use inside a quoted field.
+    RecordWriter& csvText(const string& s) {
+        for (char c : s) {
+            if (c == '"') raw('"');
+            raw(c);
+        }
+        return *this;
+    }
 
-        // Skip tab or space before the name
-        if (ss.peek() == '\t' || ss.peek() == ' ') ss.get();
+    // CSV field, quoted only when it holds a comma, quote or line break.
+    RecordWriter& csvField(const string& s) {
+        if (s.find_first_of(",\"\r\n") == string::npos) return raw(s.data(), s.size());
+        return raw('"').csvText(s).raw('"');
+    }
+};
 
-        // Read full habit name (can include spaces)
-        string name;
-        getline(ss, name);
+// One JSON object per report, on a single line:
+//   {"user":..., "habits":[{...}, ...], "mostInfluential":..., "leaderboard":[...], "multiHop":[...]}
+// Habit records use the same keys as GET /habits, plus "influencedBy".
+class JsonReport : public ReportBase, public User {
+private:
+    const vector<Habit>& habits;
 
-        // Determine if it's a good or bad habit
-        bool isGood = (typeChar == 'G' || typeChar == 'g');
+public:
+    JsonReport(const string& uname, const vector<Habit>& h)
+        : User(uname), habits(h) {}
 
-        // Add to the list
-        habits.emplace_back(name, streak, isGood);
-    }
-    fin.close();
-}
+    void generateReport(HabitGraph& graph, ostream& out = cout) override {
+        RecordWriter w(out);
+        w.raw("{\"user\":").jsonString(username).raw(",\"habits\":[");
+        graph.withIncoming([&](const IncomingView& in) {
+            for (size_t i = 0; i < habits.size(); ++i) {
+                const Habit& h = habits[i];
+                double formation = 0.0, avgMotivation = 0.0;
+                int success = 0, fail = 0;
+                h.getProgress(formation, avgMotivation, success, fail);
 
+                w.raw(i ? ",{\"name\":" : "{\"name\":").jsonString(h.getName())
+                 .raw(h.isGoodHabit() ? ",\"type\":\"Good\"" : ",\"type\":\"Bad\"")
+                 .raw(",\"streak\":").integer(h.getStreak())
+                 .raw(h.isDone() ? ",\"today\":true" : ",\"today\":false")
+                 .raw(",\"successes\":").integer(success)
+                 .raw(",\"failures\":").integer(fail)
+                 .raw(",\"averageMotivation\":").decimal(avgMotivation)
+                 .raw(",\"formation\":").decimal(formation)
+                 .raw(",\"influencedBy\":[");
+                HabitId id = h.getId();
+                if (id < in.nodes) {
+                    for (uint32_t k = in.offsets[id]; k < in.offsets[id + 1]; ++k)
+                        w.raw(k == in.offsets[id] ? "{\"habit\":" : ",{\"habit\":").jsonString(in.names.name(in.sources[k]))
+                         .raw(",\"weight\":").integer(in.weights[in.slots[k]]).raw('}');
+                }
+                w.raw("]}");
+            }
+        });
 
-    // Polymorphism
-    void displayInfo() override {
-        cout << "Habit Tracker for user: " << username << '\n';
+        auto leaders = graph.topInfluential(3);
+        w.raw("],\"mostInfluential\":");
+        if (leaders.empty()) w.raw("null");
+        else w.jsonString(leaders[0].first);
+        w.raw(",\"leaderboard\":[");
+        for (size_t i = 0; i < leaders.size(); ++i)
+            w.raw(i ? ",{\"habit\":" : "{\"habit\":").jsonString(leaders[i].first)
+             .raw(",\"weight\":").integer(leaders[i].second).raw('}');
+        auto reach = graph.topPropagated(3);
+        w.raw("],\"multiHop\":[");
+        for (size_t i = 0; i < reach.size(); ++i)
+            w.raw(i ? ",{\"habit\":" : "{\"habit\":").jsonString(reach[i].first)
+             .raw(",\"score\":").decimal(reach[i].second).raw('}');
+        w.raw("]}\n");
     }
 };
 
-// --------------------- REPORT GENERATOR -----------------------------
-class ReportBase {
-public:
-    virtual void generateReport(HabitGraph& graph) = 0;
-};
-
-class ReportGenerator : public ReportBase, public User {
+// One row per habit under a header row. influenced_by lists the incoming
+// edges as "name:weight;name:weight".
+class CsvReport : public ReportBase, public User {
 private:
     const vector<Habit>& habits;
+    bool header;   // false when appending rows to a stream that already has one
 
 public:
-    ReportGenerator(const string& uname, const vector<Habit>& h)
-        : User(uname), habits(h) {}
+    CsvReport(const string& uname, const vector<Habit>& h, bool withHeader = true)
+        : User(uname), habits(h), header(withHeader) {}
 
-    void generateReport(HabitGraph& graph) override {
-    cout << "\n==============================================\n";
-    cout << "             HABIT ANALYSIS REPORT\n";
-    cout << "==============================================\n";
-    cout << "User: " << username << "\n";
-    cout << "----------------------------------------------\n";
+    void generateReport(HabitGraph& graph, ostream& out = cout) override {
+        RecordWriter w(out);
+        if (header) w.raw("user,habit,type,streak,today,successes,failures,average_motivation,formation,influenced_by\n");
+        graph.withIncoming([&](const IncomingView& in) {
+            for (const auto& h : habits) {
+                double formation = 0.0, avgMotivation = 0.0;
+                int success = 0, fail = 0;
+                h.getProgress(formation, avgMotivation, success, fail);
 
-    if (habits.empty()) {
-        cout << "No habits to analyze yet.\n";
-        return;
+                w.csvField(username).raw(',').csvField(h.getName())
+                 .raw(h.isGoodHabit() ? ",Good," : ",Bad,").integer(h.getStreak())
+                 .raw(h.isDone() ? ",1," : ",0,").integer(success)
+                 .raw(',').integer(fail)
+                 .raw(',').decimal(avgMotivation)
+                 .raw(',').decimal(formation)
+                 .raw(",\"");
+                HabitId id = h.getId();
+                if (id < in.nodes) {
+                    for (uint32_t k = in.offsets[id]; k < in.offsets[id + 1]; ++k) {
+                        if (k != in.offsets[id]) w.raw(';');
+                        int weight = in.weights[in.slots[k]];
+                        w.csvText(in.names.name(in.sources[k])).raw(weight >= 0 ? ":+" : ":").integer(weight);
+                    }
+                }
+                w.raw("\"\n");
+            }
+        });
     }
+};
 
-    for (const auto& h : habits) {
-        double formation = 0.0, avgMotivation = 0.0;
-        int success = 0, fail = 0;
-        h.getProgress(formation, avgMotivation, success, fail);
-
-        cout << "Habit: " << h.getName() << "\n";
-        cout << "Type: " << (h.isGoodHabit() ? "Good" : "Bad") << "\n";
-        cout << "Streak: " << h.getStreak() << " days\n";
-        cout << "Successes: " << success << " | Failures: " << fail << "\n";
-        cout << "Average Motivation: " << fixed << setprecision(1) << avgMotivation << "\n";
-        cout << "Formation Progress: " << formation << "%\n";
-        cout << "----------------------------------------------\n";
-    }
+enum class ReportFormat { Text, Json, Csv };
 
-    graph.showInfluences();
-    cout << "Most Influential Habit: " << graph.getMostInfluential() << "\n";
-    cout << "==============================================\n";
+bool parseReportFormat(const string& name, ReportFormat& format) {
+    if (name == "text") format = ReportFormat::Text;
+    else if (name == "json") format = ReportFormat::Json;
+    else if (name == "csv") format = ReportFormat::Csv;
+    else return false;
+    return true;
 }
 
-};
+unique_ptr<ReportBase> makeReport(ReportFormat format, const string& user, const vector<Habit>& habits,
+                                  bool csvHeader = true) {
+    switch (format) {
+        case ReportFormat::Json: return make_unique<JsonReport>(user, habits);
+        case ReportFormat::Csv: return make_unique<CsvReport>(user, habits, csvHeader);
+        default: return make_unique<ReportGenerator>(user, habits);
+    }
+}
 
 // --------------------- SAVE / LOG FUNCTIONS -------------------------
 void saveHabitsToFile(const vector<Habit>& habits, const string& filename) {
     ofstream fout(filename);
     if (!fout) {
+        ++writeFailures;
         cerr << "Cannot open file to save habits: " << filename << '\n';
         return;
     }
@@ -531,36 +3251,99 @@ void saveHabitsToFile(const vector<Habit>& habits, const string& filename) {
 }
 
     fout.close();
-    cout << "Data saved to " << filename << '\n';
+    cerr << "Data saved to " << filename << '\n';
 }
 
-void logActivity(const string& username, const string& habitName) {
-    ofstream fout("log.txt", ios::app);
-    if (!fout) {
-        cerr << "Warning: cannot open log file.\n";
+// Renders the given records of the binary log, reading each one by offset.
+void printLogLines(const LogIndex& index, const vector<uint32_t>& lineNos) {
+    ifstream fin(index.path(), ios::binary);
+    if (!fin) {
+        cout << "No logs found.\n";
         return;
     }
+    cout << "\n==== PAST ACTIVITY LOG ====\n";
+    LogRecord r;
+    for (uint32_t n : lineNos)
+        if (index.readRecord(fin, n, r)) cout << index.render(r) << '\n';
+    if (lineNos.empty()) cout << "(no matching entries)\n";
+    cout << "===========================\n";
+}
 
-    time_t now = time(nullptr);
-    string t = ctime(&now);
-    if (!t.empty() && t.back() == '\n') t.pop_back();
-
-    fout << "[" << t << "] " << username << " completed habit: " << habitName << '\n';
-    fout.close();
+// Reads YYYY-MM-DD into a YYYYMMDD key.
+bool readDate(const string& prompt, int32_t& key) {
+    cout << prompt;
+    string text;
+    getline(cin, text);
+    int y = 0, m = 0, d = 0;
+    char dash1 = 0, dash2 = 0;
+    istringstream ss(text);
+    if (!(ss >> y >> dash1 >> m >> dash2 >> d) || dash1 != '-' || dash2 != '-') {
+        cout << "Invalid date.\n";
+        return false;
+    }
+    key = y * 10000 + m * 100 + d;
+    return true;
 }
 
-void viewLogs() {
-    ifstream fin("log.txt");
-    if (!fin) {
-        cout << "No logs found.\n";
+void viewLogs(ActivityLogger& logger) {
+    const size_t PAGE = 20;
+    const LogIndex& index = logger.getIndex();
+    size_t total = index.lineCount();
+    cout << "Log entries: " << total << "\n"
+         << "1. Latest entries\n"
+         << "2. Browse by page\n"
+         << "3. Filter by date range\n"
+         << "4. Filter by habit\n"
+         << "5. Export log as text (" << logger.getTextPath() << ")\n"
+         << "Choice: ";
+    int mode = 0;
+    if (!(cin >> mode)) {
+        cout << "Invalid input.\n";
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
         return;
     }
-    cout << "\n==== PAST ACTIVITY LOG ====\n";
-    string line;
-    while (getline(fin, line))
-        cout << line << '\n';
-    cout << "===========================\n";
-    fin.close();
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    switch (mode) {
+        case 1:
+            printLogLines(index, index.range(total > PAGE ? total - PAGE : 0, PAGE));
+            break;
+        case 2: {
+            size_t pages = max<size_t>(1, (total + PAGE - 1) / PAGE);
+            cout << "Page (1-" << pages << "): ";
+            size_t page = 0;
+            if (!(cin >> page) || page < 1 || page > pages) {
+                cout << "Invalid page.\n";
+                cin.clear();
+                cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                return;
+            }
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            printLogLines(index, index.range((page - 1) * PAGE, PAGE));
+            break;
+        }
+        case 3: {
+            int32_t from = 0, to = 0;
+            if (!readDate("From (YYYY-MM-DD): ", from) || !readDate("To (YYYY-MM-DD): ", to)) return;
+            printLogLines(index, index.query(from, to));
+            break;
+        }
+        case 4: {
+            cout << "Habit name: ";
+            string habit;
+            getline(cin, habit);
+            printLogLines(index, index.query(INT32_MIN, INT32_MAX, &habit));
+            break;
+        }
+        case 5:
+            if (logger.exportText()) cout << "Log exported to " << logger.getTextPath() << '\n';
+            else cout << "Could not export the log.\n";
+            break;
+        default:
+            cout << "Invalid option.\n";
+            break;
+    }
 }
 void showHeader(const string& username) {
     cout << "============================================\n";
@@ -570,9 +3353,765 @@ void showHeader(const string& username) {
     cout << "--------------------------------------------\n";
 }
 
+// --------------------- BATCH MODE -----------------------------------
+// Splits a command line into words; double quotes group words with spaces.
+vector<string> splitCommand(const string& line) {
+    vector<string> words;
+    string word;
+    bool quoted = false, any = false;
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            any = true;
+        } else if (!quoted && (c == ' ' || c == '\t')) {
+            if (any) words.push_back(word);
+            word.clear();
+            any = false;
+        } else {
+            word += c;
+            any = true;
+        }
+    }
+    if (any) words.push_back(word);
+    return words;
+}
+
+// Whole-string decimal integer within [lo, hi]; unlike atoi, "7x", "" and
+// out-of-range values are rejected.
+bool parseInt(const string& s, long lo, long hi, int& out) {
+    if (s.empty()) return false;
+    errno = 0;
+    char* end = nullptr;
+    long v = strtol(s.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0' || v < lo || v > hi) return false;
+    out = static_cast<int>(v);
+    return true;
+}
+
+bool parseOutcome(const string& s, bool& success) {
+    if (s == "done") success = true;
+    else if (s == "missed") success = false;
+    else return false;
+    return true;
+}
+
+const int MIN_MOTIVATION = 1, MAX_MOTIVATION = 10;
+
+// Applies batch commands to one tracker. Consecutive backfill lines are
+// held back and ingested together when another command (or finish) arrives.
+class BatchRunner {
+private:
+    HabitTracker& tracker;
+    HabitGraph& graph;
+    string username;
+    bool& csvHeaderSent;   // owned by the caller: one CSV header per output stream
+    vector<MarkEvent> backfill;
+
+    void ingestPending() {
+        if (backfill.empty()) return;
+        size_t done = tracker.ingest(backfill, graph);
+        applied += done;
+        if (done < backfill.size()) {
+            failed += backfill.size() - done;
+            cerr << "batch: " << backfill.size() - done << " backfill events named unknown habits\n";
+        }
+        backfill.clear();
+    }
+
+public:
+    size_t applied = 0, failed = 0;
+
+    BatchRunner(HabitTracker& t, HabitGraph& g, const string& user, bool& csvHeader)
+        : tracker(t), graph(g), username(user), csvHeaderSent(csvHeader) {}
+
+    void apply(size_t lineNo, const string& line) {
+        vector<string> w = splitCommand(line);
+        if (w.empty() || w[0][0] == '#') return;
+        const string& cmd = w[0];
+        if (cmd == "backfill" && w.size() >= 3) {
+            MarkEvent ev;
+            ev.habit = w[1];
+            if (parseOutcome(w[2], ev.success) &&
+                (w.size() < 4 || parseInt(w[3], MIN_MOTIVATION, MAX_MOTIVATION, ev.motivation))) {
+                backfill.push_back(std::move(ev));
+            } else {
+                ++failed;
+                cerr << "batch line " << lineNo << ": cannot apply \"" << line << "\"\n";
+            }
+            return;
+        }
+        ingestPending();
+        bool ok = false;
+        if (cmd == "add" && w.size() >= 2) {
+            ok = tracker.addHabit(w[1], w.size() < 3 || w[2] == "G" || w[2] == "g");
+        } else if (cmd == "mark" && w.size() >= 3) {
+            bool success = false;
+            int motivation = 5;
+            ok = parseOutcome(w[2], success) &&
+                 (w.size() < 4 || parseInt(w[3], MIN_MOTIVATION, MAX_MOTIVATION, motivation)) &&
+                 tracker.markHabit(w[1], success, motivation, graph);
+        } else if (cmd == "delete" && w.size() >= 2) {
+            ok = tracker.deleteHabit(w[1], graph);
+        } else if (cmd == "influence" && w.size() >= 3) {
+            int weight = 2;
+            ok = w.size() < 4 || parseInt(w[3], INT_MIN, INT_MAX, weight);
+            if (ok) tracker.addInfluence(w[1], w[2], weight, graph);
+        } else if (cmd == "newday") {
+            tracker.newDay();
+            ok = true;
+        } else if (cmd == "report") {
+            ReportFormat format = ReportFormat::Text;
+            ok = w.size() < 2 || parseReportFormat(w[1], format);
+            if (ok) {
+                bool header = format == ReportFormat::Csv && !csvHeaderSent;
+                if (header) csvHeaderSent = true;
+                makeReport(format, username, tracker.getHabits(), header)->generateReport(graph);
+            }
+        }
+        if (ok) {
+            ++applied;
+        } else {
+            ++failed;
+            cerr << "batch line " << lineNo << ": cannot apply \"" << line << "\"\n";
+        }
+    }
+
+    void finish() { ingestPending(); }
+};
+
+// Prints the closing line of a batch run; failed lines and failed writes
+// both make the exit status non-zero.
+int batchSummary(size_t applied, size_t failed) {
+    size_t writeErrors = writeFailures.load();
+    cerr << "Batch complete: " << applied << " applied, " << failed << " failed";
+    if (writeErrors) cerr << ", " << writeErrors << " write errors";
+    cerr << ".\n";
+    return failed == 0 && writeErrors == 0 ? 0 : 1;
+}
+
+// Runs one command per line, without menus or screen output per action:
+//   add <name> G|B            mark <name> done|missed <motivation>
+//   delete <name>             influence <from> <to> [weight]
+//   newday                    report
+//   backfill <name> done|missed [motivation]
+// Consecutive backfill lines are ingested together as one bulk update;
+// each backfill records a new day for the habit. Blank lines and lines starting with '#' are skipped. Data is loaded once
+// before the first command and saved once after the last.
+int runBatch(istream& in, HabitTracker& tracker, HabitGraph& graph, const string& username) {
+    tracker.loadData();
+    tracker.loadGraph(graph);
+    bool csvHeader = false;
+    BatchRunner runner(tracker, graph, username, csvHeader);
+    string line;
+    size_t lineNo = 0;
+    while (getline(in, line)) runner.apply(++lineNo, line);
+    runner.finish();
+    tracker.saveData();
+    tracker.flushExports(graph);
+    tracker.flushLog();
+    tracker.waitForWrites();
+    return batchSummary(runner.applied, runner.failed);
+}
+
+// Batch over a TenantStore: the same commands, plus `user <name>` to switch
+// the user the following lines apply to. Lines are applied in blocks per
+// user, so each block takes its tenant's shard lock once.
+int runTenantBatch(istream& in, TenantStore& store, const string& firstUser) {
+    static constexpr size_t BLOCK = 4096;
+    string user = firstUser, line;
+    vector<pair<size_t, string>> block;
+    size_t lineNo = 0, applied = 0, failed = 0;
+    bool csvHeader = false;
+    auto runBlock = [&]() {
+        if (block.empty()) return;
+        bool ok = store.with(user, [&](TenantStore::Tenant& t) {
+            BatchRunner runner(t.tracker, t.graph, user, csvHeader);
+            for (const auto& entry : block) runner.apply(entry.first, entry.second);
+            runner.finish();
+            applied += runner.applied;
+            failed += runner.failed;
+        });
+        if (!ok) {
+            cerr << "batch: invalid user name \"" << user << "\", skipping " << block.size() << " lines\n";
+            failed += block.size();
+        }
+        block.clear();
+    };
+    while (getline(in, line)) {
+        ++lineNo;
+        vector<string> w = splitCommand(line);
+        if (w.size() >= 2 && w[0] == "user") {
+            runBlock();
+            user = w[1];
+            continue;
+        }
+        block.push_back({lineNo, line});
+        if (block.size() >= BLOCK) runBlock();
+    }
+    runBlock();
+    store.unloadAll();
+    return batchSummary(applied, failed);
+}
+
+// --------------------- SERVICE MODE ---------------------------------
+// Minimal HTTP/1.1 API over a TenantStore, for the dashboard and load tests.
+// Every request names its user with ?user=; parameters come from the query
+// string or a form-encoded body.
+//   GET    /habits                       habits with their stats (JSON)
+//   POST   /habits  name [type=G|B]      add a habit
+//   DELETE /habits  name                 delete a habit
+//   POST   /mark    name result=done|missed [motivation]
+//   POST   /influence from to [weight]
+//   POST   /newday
+//   GET    /report  [format=text|json|csv]
+//   GET    /graph                        the influence graph (JSON)
+struct HttpRequest {
+    string method;
+    string path;
+    map<string, string> params;
+    bool keepAlive = true;
+};
+
+struct HttpResponse {
+    int status = 200;
+    string type = "application/json";
+    string body;
+
+    string serialize(bool keepAlive) const {
+        const char* reason = status == 200 ? "OK" : status == 201 ? "Created" : status == 400 ? "Bad Request"
+                           : status == 404 ? "Not Found" : status == 405 ? "Method Not Allowed" : status == 409 ? "Conflict"
+                           : status == 413 ? "Payload Too Large" : "Error";
+        ostringstream out;
+        out << "HTTP/1.1 " << status << ' ' << reason << "\r\n"
+            << "Content-Type: " << type << "\r\n"
+            << "Content-Length: " << body.size() << "\r\n"
+            << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n"
+            << body;
+        return out.str();
+    }
+};
+
+string urlDecode(const string& s) {
+    string out;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && isxdigit(static_cast<unsigned char>(s[i + 1]))
+                   && isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+            out += static_cast<char>(stoi(s.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+// a=1&b=2 into params; later keys do not override earlier ones.
+void parseForm(const string& form, map<string, string>& params) {
+    size_t start = 0;
+    while (start <= form.size()) {
+        size_t end = form.find('&', start);
+        if (end == string::npos) end = form.size();
+        string pair = form.substr(start, end - start);
+        size_t eq = pair.find('=');
+        if (!pair.empty()) params.emplace(urlDecode(pair.substr(0, eq)), eq == string::npos ? "" : urlDecode(pair.substr(eq + 1)));
+        start = end + 1;
+    }
+}
+
+enum class ParseResult { Incomplete, Bad, TooLarge, Done };
+
+constexpr size_t MAX_HEADER = 16 * 1024, MAX_BODY = 1024 * 1024;
+constexpr size_t MAX_REQUEST = MAX_HEADER + 4 + MAX_BODY;   // header, blank line, body
+
+// Parses one request from the front of `buf`; on Done, `used` is its length.
+ParseResult parseHttpRequest(const string& buf, HttpRequest& req, size_t& used) {
+    size_t headerEnd = buf.find("\r\n\r\n");
+    if (headerEnd == string::npos) return buf.size() > MAX_HEADER ? ParseResult::TooLarge : ParseResult::Incomplete;
+    if (headerEnd > MAX_HEADER) return ParseResult::TooLarge;
+
+    istringstream head(buf.substr(0, headerEnd));
+    string line, target, version;
+    getline(head, line);
+    istringstream first(line);
+    if (!(first >> req.method >> target >> version) || version.compare(0, 5, "HTTP/") != 0) return ParseResult::Bad;
+    req.keepAlive = version != "HTTP/1.0";
+
+    size_t length = 0;
+    while (getline(head, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t colon = line.find(':');
+        if (colon == string::npos) continue;
+        string key = line.substr(0, colon), value = line.substr(colon + 1);
+        transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        value.erase(0, value.find_first_not_of(" \t"));
+        if (key == "content-length") {
+            char* end = nullptr;
+            unsigned long long n = strtoull(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0') return ParseResult::Bad;
+            if (n > MAX_BODY) return ParseResult::TooLarge;
+            length = static_cast<size_t>(n);
+        } else if (key == "connection") {
+            transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            if (value == "close") req.keepAlive = false;
+            else if (value == "keep-alive") req.keepAlive = true;
+        }
+    }
+    if (buf.size() < headerEnd + 4 + length) return ParseResult::Incomplete;
+
+    size_t q = target.find('?');
+    req.path = target.substr(0, q);
+    if (q != string::npos) parseForm(target.substr(q + 1), req.params);
+    if (length) parseForm(buf.substr(headerEnd + 4, length), req.params);
+    used = headerEnd + 4 + length;
+    return ParseResult::Done;
+}
+
+HttpResponse httpError(int status, const string& message) {
+    HttpResponse res;
+    res.status = status;
+    res.body = json{{"error", message}}.dump();
+    return res;
+}
+
+HttpResponse httpOk(const json& body, int status = 200) {
+    HttpResponse res;
+    res.status = status;
+    res.body = body.dump();
+    return res;
+}
+
+// Runs one request against its user's tenant.
+HttpResponse handleRequest(TenantStore& store, const HttpRequest& req) {
+    auto param = [&req](const string& key, const string& fallback = "") {
+        auto it = req.params.find(key);
+        return it == req.params.end() ? fallback : it->second;
+    };
+    static const set<string> paths = {"/habits", "/mark", "/influence", "/newday", "/report", "/graph"};
+    if (!paths.count(req.path)) return httpError(404, "no such endpoint");
+    string user = param("user");
+    if (user.empty()) return httpError(400, "missing user");
+
+    HttpResponse res = httpError(405, "method not allowed");
+    bool found = store.with(user, [&](TenantStore::Tenant& t) {
+        HabitTracker& tracker = t.tracker;
+        string name = param("name");
+        bool changed = false;
+        if (req.path == "/habits" && req.method == "GET") {
+            json list = json::array();
+            tracker.readHabits([&list](const vector<Habit>& habits) {
+                for (const auto& h : habits) {
+                    double formation = 0.0, avgMotivation = 0.0;
+                    int success = 0, fail = 0;
+                    h.getProgress(formation, avgMotivation, success, fail);
+                    list.push_back({{"name", h.getName()}, {"type", h.isGoodHabit() ? "Good" : "Bad"},
+                                    {"streak", h.getStreak()}, {"today", h.isDone()},
+                                    {"successes", success}, {"failures", fail},
+                                    {"averageMotivation", avgMotivation}, {"formation", formation}});
+                }
+            });
+            res = httpOk(list);
+        } else if (req.path == "/habits" && req.method == "POST") {
+            string type = param("type", "G");
+            if (name.empty()) res = httpError(400, "missing name");
+            else if (!tracker.addHabit(name, type == "G" || type == "g")) res = httpError(409, "habit already exists");
+            else {
+                res = httpOk({{"added", name}}, 201);
+                changed = true;
+            }
+        } else if (req.path == "/habits" && req.method == "DELETE") {
+            if (!tracker.deleteHabit(name, t.graph)) res = httpError(404, "no such habit");
+            else {
+                res = httpOk({{"deleted", name}});
+                changed = true;
+            }
+        } else if (req.path == "/mark" && req.method == "POST") {
+            bool success = false;
+            int motivation = 5;
+            if (!parseOutcome(param("result"), success)) {
+                res = httpError(400, "result must be done or missed");
+            } else if (!parseInt(param("motivation", "5"), MIN_MOTIVATION, MAX_MOTIVATION, motivation)) {
+                res = httpError(400, "motivation must be a number from 1 to 10");
+            } else if (tracker.markHabit(name, success, motivation, t.graph)) {
+                res = httpOk({{"marked", name}});
+                changed = true;
+            } else {
+                res = tracker.hasHabit(name) ? httpError(409, "already marked today") : httpError(404, "no such habit");
+            }
+        } else if (req.path == "/influence" && req.method == "POST") {
+            string from = param("from"), to = param("to");
+            int weight = 2;
+            if (from.empty() || to.empty()) {
+                res = httpError(400, "missing from or to");
+            } else if (!parseInt(param("weight", "2"), INT_MIN, INT_MAX, weight)) {
+                res = httpError(400, "weight must be a whole number");
+            } else {
+                tracker.addInfluence(from, to, weight, t.graph);
+                res = httpOk({{"from", from}, {"to", to}});
+            }
+        } else if (req.path == "/newday" && req.method == "POST") {
+            tracker.newDay();
+            res = httpOk({{"newday", true}});
+        } else if (req.path == "/report" && req.method == "GET") {
+            ReportFormat format = ReportFormat::Text;
+            if (!parseReportFormat(param("format", "text"), format)) {
+                res = httpError(400, "format must be text, json or csv");
+            } else {
+                ostringstream out;
+                tracker.readHabits([&](const vector<Habit>& habits) {
+                    makeReport(format, t.user, habits)->generateReport(t.graph, out);
+                });
+                res.status = 200;
+                res.type = format == ReportFormat::Json ? "application/json"
+                         : format == ReportFormat::Csv ? "text/csv; charset=utf-8" : "text/plain; charset=utf-8";
+                res.body = out.str();
+            }
+        } else if (req.path == "/graph" && req.method == "GET") {
+            ostringstream out;
+            t.graph.writeJson(out);
+            res.status = 200;
+            res.body = out.str();
+        }
+        if (changed) tracker.commitJournal();
+        tracker.tickExports(t.graph);
+    });
+    if (!found) return httpError(400, "invalid user name");
+    return res;
+}
+
+#ifdef __linux__
+// Event loop on the calling thread: epoll watches the listening socket, the
+// connections, a signalfd for SIGINT/SIGTERM and an eventfd that workers
+// bump when a response is ready. Parsed requests run on a WorkerPool; one
+// request per connection is in flight at a time, so pipelined requests are
+// answered in order.
+int runService(uint16_t port, TenantStore& store) {
+    static constexpr uint64_t LISTEN_TAG = 0, SIGNAL_TAG = 1, WAKE_TAG = 2;
+    static constexpr chrono::milliseconds SWEEP_EVERY{500};   // idle tick for loaded tenants
+
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);   // before any worker starts
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        cerr << "Cannot listen on 127.0.0.1:" << port << ": " << strerror(errno) << '\n';
+        if (listener >= 0) close(listener);
+        return 1;
+    }
+    int signals = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    int wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    auto watch = [ep](int fd, uint64_t tag, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.u64 = tag;
+        epoll_ctl(ep, op, fd, &ev);
+    };
+    watch(listener, LISTEN_TAG, EPOLLIN, EPOLL_CTL_ADD);
+    watch(signals, SIGNAL_TAG, EPOLLIN, EPOLL_CTL_ADD);
+    watch(wake, WAKE_TAG, EPOLLIN, EPOLL_CTL_ADD);
+
+    struct Connection {
+        int fd = -1;
+        string in;
+        string out;
+        size_t sent = 0;
+        bool busy = false;         // a request is on the worker pool
+        bool closeAfter = false;   // close once `out` is written
+        bool peerClosed = false;   // client shut down its side; answer what it sent, then close
+    };
+    struct Finished {
+        uint64_t conn;
+        string bytes;
+        bool close;
+    };
+    unordered_map<uint64_t, Connection> conns;
+    uint64_t nextId = 16;
+    mutex finishedLock;            // workers are many producers, so no SpscQueue here
+    vector<Finished> finished;
+    // Reset before the eventfd closes; its destructor runs queued requests.
+    auto pool = make_unique<WorkerPool>(max(2u, thread::hardware_concurrency()));
+
+    // Output while writing. Input only when idle: a busy or still-writing
+    // connection is not read, so a client that keeps sending is held back
+    // by TCP instead of growing `in` and `out`.
+    auto interest = [](const Connection& c, bool writing) {
+        uint32_t events = 0;
+        if (writing) events |= EPOLLOUT;
+        else if (!c.peerClosed && !c.busy) events |= EPOLLIN;
+        return events;
+    };
+    auto closeConn = [&](uint64_t id) {
+        auto it = conns.find(id);
+        if (it == conns.end()) return;
+        epoll_ctl(ep, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        conns.erase(it);
+    };
+    // Writes what it can; false if the connection was closed.
+    auto flushOut = [&](uint64_t id, Connection& c) {
+        while (c.sent < c.out.size()) {
+            ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.sent += static_cast<size_t>(n);
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                watch(c.fd, id, interest(c, true), EPOLL_CTL_MOD);
+                return true;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                closeConn(id);
+                return false;
+            }
+        }
+        c.out.clear();
+        c.sent = 0;
+        if (c.closeAfter && !c.busy) {
+            closeConn(id);
+            return false;
+        }
+        watch(c.fd, id, interest(c, false), EPOLL_CTL_MOD);
+        return true;
+    };
+    auto dispatch = [&](uint64_t id, Connection& c) {
+        if (c.busy || c.closeAfter || !c.out.empty()) return;
+        HttpRequest req;
+        size_t used = 0;
+        ParseResult parsed = c.in.empty() ? ParseResult::Incomplete : parseHttpRequest(c.in, req, used);
+        if (parsed == ParseResult::Incomplete) {
+            // A half-closed client sends nothing more: close after the last response.
+            if (c.peerClosed) {
+                c.closeAfter = true;
+                if (c.out.empty()) closeConn(id);
+            }
+            return;
+        }
+        if (parsed != ParseResult::Done) {
+            c.out += httpError(parsed == ParseResult::Bad ? 400 : 413, "malformed request").serialize(false);
+            c.closeAfter = true;
+            c.in.clear();
+            flushOut(id, c);
+            return;
+        }
+        c.in.erase(0, used);
+        c.busy = true;
+        watch(c.fd, id, interest(c, false), EPOLL_CTL_MOD);
+        pool->submit([&store, &finishedLock, &finished, wake, id, req = std::move(req)] {
+            string bytes = handleRequest(store, req).serialize(req.keepAlive);
+            {
+                lock_guard<mutex> guard(finishedLock);
+                finished.push_back({id, std::move(bytes), !req.keepAlive});
+            }
+            uint64_t one = 1;
+            ssize_t ignored = write(wake, &one, sizeof(one));
+            (void)ignored;
+        });
+    };
+
+    // Requests only tick their own tenant, so idle tenants are swept on a
+    // timer to write their trailing exports and aged log entries.
+    auto sweeping = make_shared<atomic<bool>>(false);
+    auto lastSweep = chrono::steady_clock::now();
+    auto sweep = [&] {
+        auto now = chrono::steady_clock::now();
+        if (now - lastSweep < SWEEP_EVERY || sweeping->exchange(true)) return;
+        lastSweep = now;
+        pool->submit([&store, sweeping] {
+            store.forEachLoaded([](TenantStore::Tenant& t) { t.tracker.tickExports(t.graph); });
+            *sweeping = false;
+        });
+    };
+
+    cerr << "Serving on http://127.0.0.1:" << port << " (Ctrl+C to stop)\n";
+    bool running = true;
+    vector<epoll_event> events(64);
+    while (running) {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), static_cast<int>(SWEEP_EVERY.count()));
+        sweep();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            cerr << "epoll_wait: " << strerror(errno) << '\n';
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == SIGNAL_TAG) {
+                running = false;
+            } else if (tag == LISTEN_TAG) {
+                for (;;) {
+                    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (fd < 0) break;
+                    uint64_t id = nextId++;
+                    conns[id].fd = fd;
+                    watch(fd, id, EPOLLIN, EPOLL_CTL_ADD);
+                }
+            } else if (tag == WAKE_TAG) {
+                uint64_t count;
+                ssize_t ignored = read(wake, &count, sizeof(count));
+                (void)ignored;
+                vector<Finished> ready;
+                {
+                    lock_guard<mutex> guard(finishedLock);
+                    ready.swap(finished);
+                }
+                for (auto& f : ready) {
+                    auto it = conns.find(f.conn);
+                    if (it == conns.end()) continue;   // client went away meanwhile
+                    Connection& c = it->second;
+                    c.busy = false;
+                    c.closeAfter = c.closeAfter || f.close;
+                    c.out += f.bytes;
+                    if (flushOut(f.conn, c)) dispatch(f.conn, c);
+                }
+            } else {
+                auto it = conns.find(tag);
+                if (it == conns.end()) continue;
+                Connection& c = it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConn(tag);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    if (!flushOut(tag, c)) continue;
+                    dispatch(tag, c);   // pipelined requests wait for the response before them
+                }
+                if (events[i].events & EPOLLIN) {
+                    char buf[16 * 1024];
+                    bool open = true;
+                    // Enough for the largest request is buffered; the rest
+                    // stays in the socket until dispatch has consumed it.
+                    while (c.in.size() < MAX_REQUEST) {
+                        ssize_t got = recv(c.fd, buf, sizeof(buf), 0);
+                        if (got > 0) {
+                            c.in.append(buf, static_cast<size_t>(got));
+                        } else if (got < 0 && errno == EINTR) {
+                            continue;
+                        } else {
+                            open = got == 0 || errno == EAGAIN || errno == EWOULDBLOCK;
+                            if (got == 0) {
+                                c.peerClosed = true;
+                                watch(c.fd, tag, interest(c, !c.out.empty()), EPOLL_CTL_MOD);
+                            }
+                            break;
+                        }
+                    }
+                    if (!open) {
+                        closeConn(tag);
+                        continue;
+                    }
+                    dispatch(tag, c);
+                }
+            }
+        }
+    }
+
+    cerr << "Shutting down...\n";
+    for (auto& entry : conns) close(entry.second.fd);
+    conns.clear();
+    close(listener);
+    close(signals);
+    close(ep);
+    pool.reset();
+    close(wake);
+    return 0;
+}
+#endif
+
 // --------------------- MAIN -----------------------------------------
-int main() {
+int main(int argc, char* argv[]) {
     try {
+        bool asyncIo = false;
+        string batchFile, batchUser = "Guest", tenantRoot;
+        size_t maxTenants = 256;
+        int servePort = 0;
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg == "--async-io") asyncIo = true;
+            else if (arg == "--headless") headlessMode = true;
+            else if (arg == "--batch" && i + 1 < argc) batchFile = argv[++i];
+            else if (arg == "--user" && i + 1 < argc) batchUser = argv[++i];
+            else if (arg == "--tenants" && i + 1 < argc) tenantRoot = argv[++i];
+            else if (arg == "--serve" && i + 1 < argc) {
+                if (!parseInt(argv[++i], 1, 65535, servePort)) {
+                    cerr << "Invalid port: " << argv[i] << '\n';
+                    return 1;
+                }
+            } else if (arg == "--max-tenants" && i + 1 < argc) {
+                int n = 0;
+                if (!parseInt(argv[++i], 1, INT_MAX, n)) {
+                    cerr << "Invalid --max-tenants: " << argv[i] << '\n';
+                    return 1;
+                }
+                maxTenants = static_cast<size_t>(n);
+            }
+        }
+        if (!stdoutIsTerminal()) headlessMode = true;
+        // Declared before the tracker so it outlives the logger's final flush.
+        unique_ptr<BackgroundWriter> writer;
+        if (asyncIo) writer = make_unique<BackgroundWriter>();
+
+        if (servePort > 0) {
+#ifdef __linux__
+            // Requests run on many worker threads, but the background
+            // writer's queue has a single producer, so writes stay inline.
+            if (asyncIo) cerr << "Note: --async-io is ignored in service mode.\n";
+            TenantStore store(tenantRoot.empty() ? "tenants" : tenantRoot, maxTenants);
+            return runService(static_cast<uint16_t>(servePort), store);
+#else
+            cerr << "Service mode is only available on Linux.\n";
+            return 1;
+#endif
+        }
+
+        if (!batchFile.empty() && !tenantRoot.empty()) {
+            int rc = 0;
+            {
+                TenantStore store(tenantRoot, maxTenants, writer.get());
+                if (batchFile == "-") {
+                    rc = runTenantBatch(cin, store, batchUser);
+                } else {
+                    ifstream fin(batchFile);
+                    if (!fin) {
+                        cerr << "Cannot open batch file: " << batchFile << '\n';
+                        return 1;
+                    }
+                    rc = runTenantBatch(fin, store, batchUser);
+                }
+            }
+            if (writer) writer->drain();
+            return rc;
+        }
+
+        if (!batchFile.empty()) {
+            HabitIndex ids;
+            HabitTracker tracker(batchUser, ids);
+            HabitGraph graph(ids);
+            tracker.attachWriter(writer.get());
+            int rc = 0;
+            if (batchFile == "-") {
+                rc = runBatch(cin, tracker, graph, batchUser);
+            } else {
+                ifstream fin(batchFile);
+                if (!fin) {
+                    cerr << "Cannot open batch file: " << batchFile << '\n';
+                    return 1;
+                }
+                rc = runBatch(fin, tracker, graph, batchUser);
+            }
+            if (writer) writer->drain();
+            return rc;
+        }
+
         clearScreen();
         cout << "===== SMART DAILY HABIT TRACKER =====\n";
         cout << "Enter your name: ";
@@ -580,13 +4119,25 @@ int main() {
         getline(cin, name);
         if (name.empty()) name = "Guest";
 
-        HabitTracker tracker(name);
-        HabitGraph graph;
+        HabitIndex ids;   // habit name -> id, shared by tracker, graph and exports
+        HabitTracker tracker(name, ids);
+        HabitGraph graph(ids);
+        tracker.attachWriter(writer.get());
 
         tracker.loadData();
+        tracker.loadGraph(graph);
+
+        // While the user is idle, keep writing exports and log entries as
+        // they come due instead of holding them until the next action.
+        auto idleUntilInput = [&] {
+            cout << flush;
+            while (tracker.hasPendingOutput() && !waitForInput(ExportManager::WINDOW_MS))
+                tracker.tickExports(graph);
+        };
 
         int choice = 0;
         do {
+            tracker.tickExports(graph);
             clearScreen();
             showHeader(name);
             cout << "1. Add Habit\n"
@@ -597,6 +4148,7 @@ int main() {
                  << "6. View Logs\n"
                  << "7. Save & Exit\n"
                  << "Enter your choice: ";
+            idleUntilInput();
 
             if (!(cin >> choice)) {
                 cout << "Invalid input. Try again.\n";
@@ -612,6 +4164,7 @@ int main() {
                     showHeader(name);
                     tracker.addHabitInteractive();
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
@@ -620,6 +4173,7 @@ int main() {
                     showHeader(name);
                     tracker.markHabit(graph);
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
@@ -628,14 +4182,16 @@ int main() {
                     showHeader(name);
                     tracker.showAll();
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
                 case 4: {
                     clearScreen();
                     showHeader(name);
-                    tracker.deleteHabit();
+                    tracker.deleteHabit(graph);
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
@@ -645,14 +4201,16 @@ int main() {
                     ReportGenerator report(name, tracker.getHabits());
                     report.generateReport(graph);
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
                 case 6: {
                     clearScreen();
                     showHeader(name);
-                    viewLogs();
+                    tracker.viewLogs();
                     cout << "\nPress Enter to return to Main Menu...";
+                    idleUntilInput();
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
                     break;
                 }
@@ -660,6 +4218,9 @@ int main() {
                     clearScreen();
                     showHeader(name);
                     tracker.saveData();
+                    tracker.flushExports(graph);
+                    tracker.flushLog();
+                    if (writer) writer->drain();   // nothing queued is lost on exit
                     cout << "\nAll data saved successfully.\nGoodbye, " << name << "!\n";
                     break;
                 }